@@ -1,6 +1,8 @@
 #pragma once
 
 #include <X11/Xlib.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>
 #include <X11/Xatom.h>
@@ -9,9 +11,13 @@
 #include <X11/extensions/XInput2.h>
 #include <X11/extensions/Xrandr.h>
 #include <X11/extensions/Xfixes.h>
+#include <X11/extensions/shape.h>
 #include <cairo/cairo.h>
 #include <cairo/cairo-xlib.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 #include <sys/stat.h>
 #include <execinfo.h>
 #include <limits.h>
@@ -31,6 +37,7 @@
 #include "constants.h"
 
 #include "config/config.h"
+#include "timeline/timeline.h"
 #include "theme/theme.h"
 #include "background/background.h"
 #include "markers/markers.h"
@@ -40,8 +47,10 @@
 #include "shortcuts/exit.h"
 #include "shortcuts/close.h"
 #include "shortcuts/workspaces.h"
+#include "utils/clock.h"
 #include "utils/framerate.h"
 #include "utils/xlib.h"
+#include "utils/atoms.h"
 #include "utils/xinput.h"
 #include "utils/cairo.h"
 #include "ewmh/ewmh.h"
@@ -49,11 +58,17 @@
 #include "ewmh/active_window.h"
 #include "ewmh/desktops.h"
 #include "ewmh/moveresize.h"
+#include "portals/properties.h"
 #include "portals/portals.h"
+#include "portals/pool.h"
+#include "portals/index.h"
+#include "portals/stacking.h"
 #include "workspaces/workspaces.h"
 #include "workspaces/tiling.h"
+#include "session/session.h"
 #include "compositor/shadow.h"
 #include "compositor/border.h"
+#include "compositor/snapshots.h"
 #include "portals/frames.h"
 #include "portals/clients.h"
 #include "portals/focus.h"
@@ -63,6 +78,9 @@
 #include "portals/interaction.h"
 #include "portals/title.h"
 #include "portals/fullscreen.h"
+#include "portals/parking.h"
+#include "pointer/pointer.h"
 #include "events/events.h"
 #include "events/handlers.h"
 #include "events/xinput.h"
+#include "events/recorder.h"
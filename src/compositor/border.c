@@ -168,12 +168,12 @@ void draw_framed_border(cairo_t *cr, Portal *portal, Pixmap pixmap)
     XImage *strip_bottom = NULL;
     if (edge_height > 0)
     {
-        strip_left = XGetImage(
+        strip_left = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             PORTAL_BORDER_WIDTH, (int)title_height,
             1, edge_height, AllPlanes, ZPixmap
         );
-        strip_right = XGetImage(
+        strip_right = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             (int)width - PORTAL_BORDER_WIDTH - 1,
             (int)title_height, 1, edge_height,
@@ -182,7 +182,7 @@ void draw_framed_border(cairo_t *cr, Portal *portal, Pixmap pixmap)
     }
     if (edge_width > 0)
     {
-        strip_bottom = XGetImage(
+        strip_bottom = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             (int)radius,
             (int)height - PORTAL_BORDER_WIDTH - 1,
@@ -297,12 +297,12 @@ void draw_frameless_border(cairo_t *cr, Portal *portal, Pixmap pixmap)
     XImage *strip_right = NULL;
     if (edge_width > 0)
     {
-        strip_top = XGetImage(
+        strip_top = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             (int)radius, 1, edge_width, 1,
             AllPlanes, ZPixmap
         );
-        strip_bottom = XGetImage(
+        strip_bottom = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             (int)radius, (int)height - 2, edge_width, 1,
             AllPlanes, ZPixmap
@@ -310,12 +310,12 @@ void draw_frameless_border(cairo_t *cr, Portal *portal, Pixmap pixmap)
     }
     if (edge_height > 0)
     {
-        strip_left = XGetImage(
+        strip_left = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             1, (int)radius, 1, edge_height,
             AllPlanes, ZPixmap
         );
-        strip_right = XGetImage(
+        strip_right = X_ROUND_TRIP(XGetImage,
             display, pixmap,
             (int)width - 2, (int)radius, 1, edge_height,
             AllPlanes, ZPixmap
@@ -19,12 +19,6 @@ static cairo_t *buffer_cr = NULL;
 static cairo_surface_t *buffer_surface = NULL;
 static Pixmap buffer_pixmap = None;
 
-/**
- * Tracks which client windows have been composite-redirected for the purpose
- * of split rendering misaligned framed portals. Indexed by portal index.
- */
-static Window redirected_clients[MAX_PORTALS] = {0};
-
 static int screen_width = 0;
 static int screen_height = 0;
 
@@ -36,7 +30,7 @@ static void init_compositor()
 
     // Check if XComposite extension is available.
     int event_base, error_base;
-    if (!XCompositeQueryExtension(display, &event_base, &error_base))
+    if (!X_ROUND_TRIP(XCompositeQueryExtension, display, &event_base, &error_base))
     {
         LOG_WARNING("XComposite extension not available, compositor disabled.");
         return;
@@ -44,7 +38,7 @@ static void init_compositor()
 
     // Check XComposite version (need at least 0.2 for NameWindowPixmap).
     int major = 0, minor = 0;
-    XCompositeQueryVersion(display, &major, &minor);
+    X_ROUND_TRIP(XCompositeQueryVersion, display, &major, &minor);
     if (major == 0 && minor < 2)
     {
         LOG_WARNING("XComposite version too old (need 0.2+), compositor disabled.");
@@ -102,6 +96,30 @@ static Portal *find_fullscreen_portal()
     return NULL;
 }
 
+static void flag_acquisition_failure(Display *display, XErrorEvent *error, void *data)
+{
+    (void)display;
+    (void)error;
+
+    // The error arrives after the frame was drawn, so flag the portal to skip
+    // its next frame instead. The window is looked up again, as the portal
+    // may have been destroyed in the meantime.
+    Portal *portal = find_portal_by_window((Window)(uintptr_t)data);
+    if (portal != NULL) portal->surface_failed = true;
+}
+
+/**
+ * Checks whether a portal's surface should be skipped for this frame, due to
+ * an acquisition failure reported since the previous frame. The acquisition
+ * is retried on the frame after.
+ */
+static bool consume_surface_failure(Portal *portal)
+{
+    if (!portal->surface_failed) return false;
+    portal->surface_failed = false;
+    return true;
+}
+
 /**
  * Acquires a window's composite pixmap and wraps it in a Cairo surface.
  *
@@ -116,6 +134,8 @@ static Portal *find_fullscreen_portal()
  * @return - `NULL` If the window is not viewable or acquisition failed.
  *
  * @note Caller owns both the returned surface and *out_pixmap.
+ * @note Failures of the pixmap request are reported asynchronously, by
+ * flagging the portal of the window, see `consume_surface_failure()`.
  */
 static cairo_surface_t *acquire_window_surface(
     Window window,
@@ -129,34 +149,31 @@ static cairo_surface_t *acquire_window_surface(
     Display *display = DefaultDisplay;
     *out_pixmap = None;
 
-    // Grab the server to prevent window changes during acquisition.
-    XGrabServer(display);
-
-    // Verify the window is viewable if requested.
+    // Verify the window is viewable if requested. This is done without
+    // grabbing the server, so it is not held while waiting for the reply.
     if (check_viewable)
     {
         XWindowAttributes attrs;
-        if (!XGetWindowAttributes(display, window, &attrs)
+        if (!X_ROUND_TRIP(XGetWindowAttributes, display, window, &attrs)
             || attrs.map_state != IsViewable)
         {
-            XUngrabServer(display);
             return NULL;
         }
     }
 
-    // Get the composite pixmap. Trap errors because the call can fail
-    // with BadMatch (window not composite-redirected) for rapidly
-    // created/destroyed override-redirect windows. X11 errors are
-    // async, so the pixmap check alone cannot detect the failure.
-    x_trap_errors(display);
+    // Get the composite pixmap. The call can fail with BadMatch (window not
+    // composite-redirected, or no longer viewable) for rapidly
+    // created/destroyed override-redirect windows. The failure is tracked
+    // without waiting for it, drawing from the invalid pixmap in the meantime
+    // only causes errors ignored by the portal's own error range.
+    unsigned long first_request = x_begin_error_range(
+        display, flag_acquisition_failure, (void*)(uintptr_t)window
+    );
     Pixmap pixmap = XCompositeNameWindowPixmap(display, window);
-    int error = x_untrap_errors(display);
-
-    // Release the server grab.
-    XUngrabServer(display);
+    x_end_error_range(display, first_request);
 
-    // Return early if there was an error or the pixmap is invalid.
-    if (error || pixmap == None)
+    // Return early if the pixmap is invalid.
+    if (pixmap == None)
     {
         return NULL;
     }
@@ -181,10 +198,13 @@ static void draw_fullscreen_portal(Portal *portal)
 {
     if (!compositor_enabled) return;
 
+    // Skip the portal for a frame if its last acquisition failed.
+    if (consume_surface_failure(portal)) return;
+
     // Acquire the client pixmap directly (bypass frame).
     Pixmap pixmap;
     cairo_surface_t *surface = acquire_window_surface(
-        portal->client_window, portal->client_visual,
+        portal->client_window, portal->cold->client_visual,
         screen_width, screen_height, true, &pixmap
     );
     if (surface == NULL) return;
@@ -214,18 +234,14 @@ static void draw_split_content(
     Display *display = DefaultDisplay;
 
     // Ensure client has its own composite pixmap.
-    int portal_index = get_portal_index(portal);
-    if (portal_index >= 0
-        && redirected_clients[portal_index]
-            != portal->client_window)
+    if (portal->cold->redirected_client != portal->client_window)
     {
         XCompositeRedirectWindow(
             display,
             portal->client_window,
             CompositeRedirectAutomatic
         );
-        redirected_clients[portal_index] =
-            portal->client_window;
+        portal->cold->redirected_client = portal->client_window;
     }
 
     // Paint the title bar from the frame pixmap.
@@ -251,7 +267,7 @@ static void draw_split_content(
     unsigned int client_height = portal->geometry.height - PORTAL_TITLE_BAR_HEIGHT;
     Pixmap client_pixmap;
     cairo_surface_t *client_surface = acquire_window_surface(
-        portal->client_window, portal->client_visual,
+        portal->client_window, portal->cold->client_visual,
         portal->geometry.width, client_height,
         true, &client_pixmap
     );
@@ -284,24 +300,37 @@ static void draw_portal(Portal *portal)
     if (portal->visibility != PORTAL_VISIBLE) return;
     if (portal->initialized == false) return;
 
+    // Skip the portal for a frame if its last acquisition failed.
+    if (consume_surface_failure(portal)) return;
+
     Display *display = DefaultDisplay;
     bool has_frame = is_portal_frame_valid(portal);
-    Visual *visual = has_frame ? portal->frame_visual : portal->client_visual;
+    Visual *visual = has_frame ? portal->cold->frame_visual : portal->cold->client_visual;
 
     // Get the window to composite (frame if it exists, otherwise client).
     Window target_window = has_frame ? portal->frame_window : portal->client_window;
 
+    TimelineSpan portal_span = begin_timeline_span("compositor", "draw_portal");
+    portal_span.window = target_window;
+
     // Acquire the window pixmap as a Cairo surface.
     // Override-redirect windows need viewability checks because clients
     // control them and can change state rapidly. Framed portals are
     // controlled by us, so we trust `portal->visibility`.
+    TimelineSpan acquire_span = begin_timeline_span("compositor", "acquire_surface");
+    acquire_span.window = target_window;
     Pixmap pixmap;
     cairo_surface_t *window_surface = acquire_window_surface(
         target_window, visual,
         portal->geometry.width, portal->geometry.height,
         portal->override_redirect, &pixmap
     );
-    if (window_surface == NULL) return;
+    end_timeline_span(&acquire_span);
+    if (window_surface == NULL)
+    {
+        end_timeline_span(&portal_span);
+        return;
+    }
 
     // Draw the window surface to the off-screen buffer based on decoration kind.
     PortalDecoration kind = get_portal_decoration_kind(portal);
@@ -401,7 +430,10 @@ static void draw_portal(Portal *portal)
     cairo_restore(buffer_cr);
 
     // Draw border.
+    TimelineSpan border_span = begin_timeline_span("compositor", "draw_border");
+    border_span.window = target_window;
     draw_border(buffer_cr, portal, pixmap);
+    end_timeline_span(&border_span);
 
 done:
     // Clear the source to release Cairo's reference to `window_surface`.
@@ -414,6 +446,8 @@ done:
     // takes effect on the next frame.
     if (has_frame && get_theme_mode() == THEME_MODE_ADAPTIVE)
     {
+        TimelineSpan sample_span = begin_timeline_span("compositor", "sample_luminance");
+        sample_span.window = target_window;
         float luminance = x_average_luminance(
             display, buffer_pixmap,
             portal->geometry.x_root,
@@ -429,11 +463,18 @@ done:
                 draw_portal_frame(portal);
             }
         }
+        end_timeline_span(&sample_span);
     }
 
     // Cleanup.
     cairo_surface_destroy(window_surface);
     XFreePixmap(display, pixmap);
+    end_timeline_span(&portal_span);
+}
+
+bool is_compositor_enabled()
+{
+    return compositor_enabled;
 }
 
 static void redraw_compositor()
@@ -442,30 +483,50 @@ static void redraw_compositor()
 
     Display *display = DefaultDisplay;
 
+    TimelineSpan redraw_span = begin_timeline_span("compositor", "redraw");
+
     // Draw all portals, or just the fullscreen one to the off-screen buffer.
     Portal *fullscreen = find_fullscreen_portal();
     if (fullscreen == NULL)
     {
+        TimelineSpan background_span = begin_timeline_span("compositor", "draw_background");
         draw_background(buffer_cr);
+        end_timeline_span(&background_span);
 
         unsigned int portal_count = 0;
         Portal **portals = get_sorted_portals(&portal_count);
         for (unsigned int i = 0; i < portal_count; i++)
         {
-            if (portals[i] != NULL) draw_portal(portals[i]);
+            if (portals[i] == NULL) continue;
+
+            // Ignore errors caused by the portal's windows vanishing while
+            // it is being drawn, without synchronizing with the server.
+            unsigned long first_request = x_begin_error_range(display, NULL, NULL);
+            draw_portal(portals[i]);
+            x_end_error_range(display, first_request);
         }
     }
     else
     {
+        unsigned long first_request = x_begin_error_range(display, NULL, NULL);
         draw_fullscreen_portal(fullscreen);
+        x_end_error_range(display, first_request);
     }
 
+    // Cover the live content with the snapshot of the workspace switched to,
+    // fading out while its clients remap and repaint.
+    draw_workspace_snapshot_fade(buffer_cr, screen_width, screen_height);
+
     // Copy the completed buffer to the root window in one operation.
+    TimelineSpan present_span = begin_timeline_span("compositor", "present");
     cairo_set_source_surface(root_cr, buffer_surface, 0, 0);
     cairo_paint(root_cr);
 
     // Flush to ensure drawing is displayed.
     XFlush(display);
+    end_timeline_span(&present_span);
+
+    end_timeline_span(&redraw_span);
 }
 
 HANDLE(Initialize)
@@ -478,14 +539,13 @@ HANDLE(Update)
     redraw_compositor();
 }
 
-HANDLE(PortalDestroyed)
+HANDLE(WorkspaceSwitched)
 {
-    PortalDestroyedEvent *_event = &event->portal_destroyed;
+    WorkspaceSwitchedEvent *_event = &event->workspace_switched;
+    if (!compositor_enabled) return;
 
-    // Clear the composite redirect tracking for the destroyed portal.
-    int portal_index = get_portal_index(_event->portal);
-    if (portal_index >= 0)
-    {
-        redirected_clients[portal_index] = 0;
-    }
+    // The buffer still holds the last frame of the old workspace, as no
+    // frame was composited since the switch.
+    capture_workspace_snapshot(_event->old_workspace, buffer_surface, screen_width, screen_height);
+    begin_workspace_snapshot_fade(_event->new_workspace);
 }
@@ -9,3 +9,13 @@
 
 /** The radius of the rounded corners for frameless windows in pixels. */
 #define PORTAL_FRAMELESS_CORNER_RADIUS 4
+
+/**
+ * Checks whether the compositor is enabled, and thereby composites all
+ * subwindows of the root window itself.
+ *
+ * @return - `true` The compositor was initialized successfully.
+ * @return - `false` The compositor is disabled, as the XComposite extension
+ * is unavailable or too old.
+ */
+bool is_compositor_enabled();
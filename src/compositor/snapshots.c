@@ -0,0 +1,227 @@
+/**
+ * This code is responsible for keeping a snapshot of the last composited
+ * frame of each workspace. When switching workspaces the snapshot is shown
+ * immediately and cross-faded to the live content, hiding the clients that
+ * are still remapping and repainting. The downscaled thumbnails are also
+ * exposed to pagers.
+ */
+
+#include "../all.h"
+
+/** A type representing which workspace snapshots are kept. */
+typedef enum {
+    SNAPSHOT_MODE_OFF,
+    SNAPSHOT_MODE_THUMBNAIL,
+    SNAPSHOT_MODE_FULL
+} SnapshotMode;
+
+/** A type representing the snapshot of a single workspace. */
+typedef struct {
+    int width, height;               // The size of the captured frame.
+    Pixmap thumbnail_pixmap;
+    cairo_surface_t *thumbnail_surface;
+    Pixmap full_pixmap;
+    cairo_surface_t *full_surface;
+} WorkspaceSnapshot;
+
+static SnapshotMode snapshot_mode = SNAPSHOT_MODE_THUMBNAIL;
+
+static WorkspaceSnapshot snapshots[MAX_WORKSPACES] = {{0}};
+
+/** The workspace being faded to, or -1 if no fade is in progress. */
+static int fade_workspace = -1;
+static uint64_t fade_start_us = 0;
+
+static cairo_surface_t *create_snapshot_surface(int width, int height, Pixmap *out_pixmap)
+{
+    Display *display = DefaultDisplay;
+    int screen = DefaultScreen(display);
+
+    // Create a pixmap in the X server, so the snapshot never leaves it.
+    *out_pixmap = XCreatePixmap(display, DefaultRootWindow(display), width, height, DefaultDepth(display, screen));
+    return cairo_xlib_surface_create(display, *out_pixmap, DefaultVisual(display, screen), width, height);
+}
+
+static void release_workspace_snapshot(WorkspaceSnapshot *snapshot)
+{
+    Display *display = DefaultDisplay;
+
+    // Destroy the surfaces before freeing the pixmaps they draw to.
+    if (snapshot->thumbnail_surface != NULL) cairo_surface_destroy(snapshot->thumbnail_surface);
+    if (snapshot->thumbnail_pixmap != None) XFreePixmap(display, snapshot->thumbnail_pixmap);
+    if (snapshot->full_surface != NULL) cairo_surface_destroy(snapshot->full_surface);
+    if (snapshot->full_pixmap != None) XFreePixmap(display, snapshot->full_pixmap);
+    *snapshot = (WorkspaceSnapshot){0};
+}
+
+static void release_workspace_snapshots()
+{
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        release_workspace_snapshot(&snapshots[i]);
+    }
+    fade_workspace = -1;
+}
+
+static void copy_snapshot(cairo_surface_t *target, cairo_surface_t *frame, double scale)
+{
+    cairo_t *cr = cairo_create(target);
+    cairo_scale(cr, scale, scale);
+    cairo_set_source_surface(cr, frame, 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_GOOD);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+}
+
+void capture_workspace_snapshot(int workspace, cairo_surface_t *frame, int width, int height)
+{
+    if (snapshot_mode == SNAPSHOT_MODE_OFF) return;
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
+    WorkspaceSnapshot *snapshot = &snapshots[workspace];
+
+    TimelineSpan span = begin_timeline_span("compositor", "capture_workspace_snapshot");
+
+    // Release all snapshots once the screen size changed, as none of them
+    // match the composited frames anymore.
+    if (snapshot->thumbnail_surface != NULL &&
+        (snapshot->width != width || snapshot->height != height))
+    {
+        release_workspace_snapshots();
+    }
+    snapshot->width = width;
+    snapshot->height = height;
+
+    // Capture the downscaled thumbnail, creating it on first use.
+    if (snapshot->thumbnail_surface == NULL)
+    {
+        snapshot->thumbnail_surface = create_snapshot_surface(
+            common.int_max(1, width / WORKSPACE_THUMBNAIL_SCALE),
+            common.int_max(1, height / WORKSPACE_THUMBNAIL_SCALE),
+            &snapshot->thumbnail_pixmap
+        );
+    }
+    copy_snapshot(snapshot->thumbnail_surface, frame, 1.0 / WORKSPACE_THUMBNAIL_SCALE);
+
+    // Capture the full size snapshot, if configured.
+    if (snapshot_mode == SNAPSHOT_MODE_FULL)
+    {
+        if (snapshot->full_surface == NULL)
+        {
+            snapshot->full_surface = create_snapshot_surface(width, height, &snapshot->full_pixmap);
+        }
+        copy_snapshot(snapshot->full_surface, frame, 1.0);
+    }
+
+    end_timeline_span(&span);
+
+    // Call all event handlers of the WorkspaceSnapshotted event.
+    call_event_handlers((Event*)&(WorkspaceSnapshottedEvent){
+        .type = WorkspaceSnapshotted,
+        .workspace = workspace
+    });
+}
+
+void begin_workspace_snapshot_fade(int workspace)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
+    if (snapshots[workspace].thumbnail_surface == NULL) return;
+
+    fade_workspace = workspace;
+    fade_start_us = get_monotonic_time_us();
+}
+
+bool draw_workspace_snapshot_fade(cairo_t *cr, int width, int height)
+{
+    if (fade_workspace == -1) return false;
+    WorkspaceSnapshot *snapshot = &snapshots[fade_workspace];
+
+    // End the fade if the snapshot doesn't match the frame size.
+    if (snapshot->width != width || snapshot->height != height)
+    {
+        fade_workspace = -1;
+        return false;
+    }
+
+    // End the fade once its duration has passed.
+    uint64_t elapsed_us = get_monotonic_time_us() - fade_start_us;
+    if (elapsed_us >= WORKSPACE_SNAPSHOT_FADE_MS * 1000UL)
+    {
+        fade_workspace = -1;
+        return false;
+    }
+    double opacity = 1.0 - (double)elapsed_us / (WORKSPACE_SNAPSHOT_FADE_MS * 1000.0);
+
+    // Draw the full size snapshot if available, the thumbnail upscaled
+    // otherwise.
+    cairo_save(cr);
+    cairo_rectangle(cr, 0, 0, width, height);
+    cairo_clip(cr);
+    if (snapshot->full_surface != NULL)
+    {
+        cairo_set_source_surface(cr, snapshot->full_surface, 0, 0);
+    }
+    else
+    {
+        cairo_scale(cr, WORKSPACE_THUMBNAIL_SCALE, WORKSPACE_THUMBNAIL_SCALE);
+        cairo_set_source_surface(cr, snapshot->thumbnail_surface, 0, 0);
+        cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_BILINEAR);
+    }
+    cairo_paint_with_alpha(cr, opacity);
+    cairo_restore(cr);
+    return true;
+}
+
+Pixmap get_workspace_thumbnail(int workspace)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return None;
+    return snapshots[workspace].thumbnail_pixmap;
+}
+
+HANDLE(Initialize)
+{
+    // Read which workspace snapshots are kept from config.
+    char mode_value[CONFIG_MAX_VALUE_LENGTH];
+    common.get_config_str(
+        mode_value, sizeof(mode_value),
+        CFG_KEY_WORKSPACE_SNAPSHOTS, CFG_DEFAULT_WORKSPACE_SNAPSHOTS
+    );
+    if (strcmp(mode_value, "off") == 0)
+    {
+        snapshot_mode = SNAPSHOT_MODE_OFF;
+    }
+    else if (strcmp(mode_value, "full") == 0)
+    {
+        snapshot_mode = SNAPSHOT_MODE_FULL;
+    }
+    else
+    {
+        snapshot_mode = SNAPSHOT_MODE_THUMBNAIL;
+    }
+}
+
+HANDLE(ConfigureNotify)
+{
+    XConfigureEvent *_event = &event->xconfigure;
+    Display *display = DefaultDisplay;
+
+    // Release the snapshots when the root window is resized (e.g., by a
+    // RandR resolution change), they are recreated at the new size.
+    if (_event->window != DefaultRootWindow(display)) return;
+    bool resized = false;
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        if (snapshots[i].thumbnail_surface == NULL) continue;
+        if (snapshots[i].width == _event->width && snapshots[i].height == _event->height) continue;
+        resized = true;
+    }
+    if (!resized) return;
+    release_workspace_snapshots();
+
+    // Call all event handlers of the WorkspaceSnapshotted event, so the
+    // released thumbnails are no longer advertised.
+    call_event_handlers((Event*)&(WorkspaceSnapshottedEvent){
+        .type = WorkspaceSnapshotted,
+        .workspace = -1
+    });
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "../all.h"
+
+/** The factor by which workspace thumbnails are downscaled. */
+#define WORKSPACE_THUMBNAIL_SCALE 8
+
+/** The duration of the cross-fade from a workspace snapshot to live content. */
+#define WORKSPACE_SNAPSHOT_FADE_MS 150
+
+/**
+ * Captures the last composited frame of a workspace as its snapshot, as a
+ * downscaled thumbnail and, if configured, at full size.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ * @param frame The surface holding the last composited frame.
+ * @param width The width of the frame.
+ * @param height The height of the frame.
+ *
+ * @note Has no effect if workspace snapshots are disabled in the
+ * configuration.
+ */
+void capture_workspace_snapshot(int workspace, cairo_surface_t *frame, int width, int height);
+
+/**
+ * Begins the cross-fade from the snapshot of a workspace to its live
+ * content, for when the workspace is switched to.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ */
+void begin_workspace_snapshot_fade(int workspace);
+
+/**
+ * Draws the snapshot of the workspace being faded to over the live content,
+ * with an opacity decreasing over the fade duration.
+ *
+ * @param cr The Cairo context to draw on.
+ * @param width The width of the area to cover.
+ * @param height The height of the area to cover.
+ *
+ * @return - `true` The fade is in progress.
+ * @return - `false` No fade is in progress, nothing was drawn.
+ */
+bool draw_workspace_snapshot_fade(cairo_t *cr, int width, int height);
+
+/**
+ * Retrieves the thumbnail pixmap of a workspace.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ *
+ * @return - `Pixmap` The thumbnail pixmap, downscaled by
+ * `WORKSPACE_THUMBNAIL_SCALE`.
+ * @return - `None` No thumbnail was captured yet.
+ */
+Pixmap get_workspace_thumbnail(int workspace);
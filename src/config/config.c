@@ -21,6 +21,35 @@ static const char default_config[] =
     "# The gap between tiled portals in pixels.\n"
     CFG_KEY_TILE_GAP "=" CFG_DEFAULT_TILE_GAP "\n"
     "\n"
+    "# The maximum number of windows per workspace.\n"
+    CFG_KEY_WORKSPACE_CAPACITY "=" CFG_DEFAULT_WORKSPACE_CAPACITY "\n"
+    "\n"
+    "# Whether windows on inactive workspaces stay mapped but hidden.\n"
+    "# May be 'true' or 'false'. Switching back is instant, as their\n"
+    "# content is kept, at the cost of memory.\n"
+    CFG_KEY_KEEP_WORKSPACES_MAPPED "=" CFG_DEFAULT_KEEP_WORKSPACES_MAPPED "\n"
+    "\n"
+    "# The memory in MB that mapped inactive workspaces may take up,\n"
+    "# beyond which the least recently used ones are unmapped.\n"
+    CFG_KEY_MAPPED_WORKSPACES_MEMORY_CAP "=" CFG_DEFAULT_MAPPED_WORKSPACES_MEMORY_CAP "\n"
+    "\n"
+    "# The snapshots kept of each workspace, shown while switching.\n"
+    "# May be 'off', 'thumbnail' or 'full'. 'full' gives a sharp preview\n"
+    "# at the cost of a screen-sized pixmap per workspace.\n"
+    CFG_KEY_WORKSPACE_SNAPSHOTS "=" CFG_DEFAULT_WORKSPACE_SNAPSHOTS "\n"
+    "\n"
+    "# ---\n"
+    "# Diagnostics\n"
+    "# --- \n"
+    "\n"
+    "# A file path where dispatched events are recorded for replay.\n"
+    "# Leave empty to disable recording.\n"
+    CFG_KEY_EVENT_TRACE_PATH "=" CFG_DEFAULT_EVENT_TRACE_PATH "\n"
+    "\n"
+    "# A file path where the timeline is written on SIGUSR2.\n"
+    "# Leave empty to disable the timeline tracer.\n"
+    CFG_KEY_TIMELINE_PATH "=" CFG_DEFAULT_TIMELINE_PATH "\n"
+    "\n"
     "# ---\n"
     "# Background\n"
     "# --- \n"
@@ -13,6 +13,30 @@
 #define CFG_KEY_TILE_GAP "tile_gap"
 #define CFG_DEFAULT_TILE_GAP "6"
 
+/** Configuration key for the maximum number of portals per workspace. */
+#define CFG_KEY_WORKSPACE_CAPACITY "workspace_capacity"
+#define CFG_DEFAULT_WORKSPACE_CAPACITY "8"
+
+/** Configuration key for keeping inactive workspaces mapped but hidden. */
+#define CFG_KEY_KEEP_WORKSPACES_MAPPED "keep_workspaces_mapped"
+#define CFG_DEFAULT_KEEP_WORKSPACES_MAPPED "false"
+
+/** Configuration key for the memory cap of mapped inactive workspaces in MB. */
+#define CFG_KEY_MAPPED_WORKSPACES_MEMORY_CAP "mapped_workspaces_memory_cap"
+#define CFG_DEFAULT_MAPPED_WORKSPACES_MEMORY_CAP "256"
+
+/** Configuration key for which workspace snapshots the compositor keeps. */
+#define CFG_KEY_WORKSPACE_SNAPSHOTS "workspace_snapshots"
+#define CFG_DEFAULT_WORKSPACE_SNAPSHOTS "thumbnail"
+
+/** Configuration key for the event trace path, empty to disable recording. */
+#define CFG_KEY_EVENT_TRACE_PATH "event_trace_path"
+#define CFG_DEFAULT_EVENT_TRACE_PATH ""
+
+/** Configuration key for the timeline path, empty to disable the tracer. */
+#define CFG_KEY_TIMELINE_PATH "timeline_path"
+#define CFG_DEFAULT_TIMELINE_PATH ""
+
 /** Configuration key for the background mode. */
 #define CFG_KEY_BACKGROUND_MODE "background_mode"
 #define CFG_DEFAULT_BACKGROUND_MODE "solid"
@@ -1,8 +1,41 @@
 #include "../all.h"
 
-static Time last_update_time = 0;
-static Time last_select_time = 0;
+typedef struct {
+    bool active;
+    int fd;
+    EventSourceCallback *callback;
+    void *data;
+} EventSource;
+
+static EventSource event_sources[MAX_EVENT_SOURCES] = {{0}};
+static int epoll_fd = -1;
+
+static int xi_opcode = 0;
 static Time throttle_ms = 0;
+static bool update_pending = false;
+static int timer_fd = -1;
+
+/** The priority classes of events, in the order they are dispatched. */
+typedef enum {
+    EVENT_PRIORITY_INPUT,
+    EVENT_PRIORITY_STRUCTURE,
+    EVENT_PRIORITY_PROPERTY,
+    EVENT_PRIORITY_COUNT
+} EventPriority;
+
+/**
+ * A queue of events awaiting dispatch. Events are stored in `XEvent` sized
+ * slots, which fit every `Event`.
+ */
+typedef struct {
+    XEvent events[EVENT_QUEUE_CAPACITY];
+    int head;
+    int count;
+} EventQueue;
+
+_Static_assert(sizeof(Event) <= sizeof(XEvent), "Event must fit an XEvent slot.");
+
+static EventQueue event_queues[EVENT_PRIORITY_COUNT] = {0};
 
 static const long x_root_event_mask =
     StructureNotifyMask |
@@ -14,7 +47,334 @@ static const long xi_root_event_mask =
     XI_RawButtonReleaseMask |
     XI_RawMotionMask |
     XI_RawKeyPressMask |
-    XI_RawKeyReleaseMask;
+    XI_RawKeyReleaseMask |
+    XI_HierarchyChangedMask;
+
+static const int handled_signals[] = {
+    SIGINT,
+    SIGTERM,
+    SIGHUP,
+    SIGUSR1,
+    SIGUSR2
+};
+
+/**
+ * Determines the priority class of an event, lower values being dispatched
+ * first.
+ */
+static EventPriority get_event_priority(int type)
+{
+    switch (type)
+    {
+        case RawButtonPress:
+        case RawButtonRelease:
+        case RawMotionNotify:
+        case RawKeyPress:
+        case RawKeyRelease:
+            return EVENT_PRIORITY_INPUT;
+        case PropertyNotify:
+        case Expose:
+            return EVENT_PRIORITY_PROPERTY;
+        default:
+            return EVENT_PRIORITY_STRUCTURE;
+    }
+}
+
+static bool is_event_queue_full()
+{
+    for (int i = 0; i < EVENT_PRIORITY_COUNT; i++)
+    {
+        if (event_queues[i].count >= EVENT_QUEUE_CAPACITY) return true;
+    }
+    return false;
+}
+
+static bool is_event_queue_empty()
+{
+    for (int i = 0; i < EVENT_PRIORITY_COUNT; i++)
+    {
+        if (event_queues[i].count > 0) return false;
+    }
+    return true;
+}
+
+static void push_event(Event *event)
+{
+    EventQueue *queue = &event_queues[get_event_priority(event->type)];
+
+    // Coalesce consecutive motion events of the same device, summing their
+    // deltas, so motion handlers run once per run of motion events.
+    if (event->type == RawMotionNotify && queue->count > 0)
+    {
+        int tail = (queue->head + queue->count - 1) % EVENT_QUEUE_CAPACITY;
+        Event *tail_event = (Event*)&queue->events[tail];
+        if (tail_event->type == RawMotionNotify &&
+            tail_event->raw_motion_notify.device_id == event->raw_motion_notify.device_id)
+        {
+            tail_event->raw_motion_notify.delta_x += event->raw_motion_notify.delta_x;
+            tail_event->raw_motion_notify.delta_y += event->raw_motion_notify.delta_y;
+            return;
+        }
+    }
+
+    // Append the event to the queue of its priority class.
+    int tail = (queue->head + queue->count) % EVENT_QUEUE_CAPACITY;
+    *(Event*)&queue->events[tail] = *event;
+    queue->count++;
+}
+
+static bool pop_event(Event *out_event)
+{
+    // Take the oldest event of the highest priority class.
+    for (int i = 0; i < EVENT_PRIORITY_COUNT; i++)
+    {
+        EventQueue *queue = &event_queues[i];
+        if (queue->count == 0) continue;
+        *out_event = *(Event*)&queue->events[queue->head];
+        queue->head = (queue->head + 1) % EVENT_QUEUE_CAPACITY;
+        queue->count--;
+        return true;
+    }
+    return false;
+}
+
+int register_event_source(int fd, uint32_t events, EventSourceCallback *callback, void *data)
+{
+    // Find a free event source slot.
+    EventSource *source = NULL;
+    for (int i = 0; i < MAX_EVENT_SOURCES; i++)
+    {
+        if (!event_sources[i].active)
+        {
+            source = &event_sources[i];
+            break;
+        }
+    }
+    if (source == NULL) return -1;
+
+    // Add the file descriptor to the epoll set.
+    struct epoll_event epoll_event = {
+        .events = events,
+        .data.ptr = source
+    };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &epoll_event) == -1) return -2;
+
+    // Store the event source.
+    *source = (EventSource){
+        .active = true,
+        .fd = fd,
+        .callback = callback,
+        .data = data
+    };
+    return 0;
+}
+
+int unregister_event_source(int fd)
+{
+    for (int i = 0; i < MAX_EVENT_SOURCES; i++)
+    {
+        EventSource *source = &event_sources[i];
+        if (!source->active || source->fd != fd) continue;
+
+        // Remove the file descriptor from the epoll set.
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        source->active = false;
+        return 0;
+    }
+    return -1;
+}
+
+static void handle_display_ready(int fd, uint32_t events, void *data)
+{
+    (void)fd; (void)events; (void)data;
+
+    // Read the available events into the Xlib event queue, without flushing.
+    XEventsQueued(DefaultDisplay, QueuedAfterReading);
+}
+
+static void handle_timer_ready(int fd, uint32_t events, void *data)
+{
+    (void)events; (void)data;
+
+    // Acknowledge the expirations, missed frames are not made up for.
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+
+    update_pending = true;
+}
+
+static void handle_signal_ready(int fd, uint32_t events, void *data)
+{
+    (void)events; (void)data;
+
+    struct signalfd_siginfo info;
+    while (read(fd, &info, sizeof(info)) == sizeof(info))
+    {
+        // Call all event handlers of the SignalReceived event.
+        int signal_number = (int)info.ssi_signo;
+        call_event_handlers((Event*)&(SignalReceivedEvent){
+            .type = SignalReceived,
+            .signal = signal_number
+        });
+
+        // Terminate on the signals that would have terminated us by default.
+        if (signal_number == SIGINT ||
+            signal_number == SIGTERM ||
+            signal_number == SIGHUP)
+        {
+            exit(EXIT_SUCCESS);
+        }
+    }
+}
+
+static void initialize_event_sources(Display *display)
+{
+    // Create the epoll instance.
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+    {
+        LOG_ERROR("Could not create epoll instance.");
+        exit(EXIT_FAILURE);
+    }
+
+    // Watch the X connection.
+    int display_fd = ConnectionNumber(display);
+    if (register_event_source(display_fd, EPOLLIN, handle_display_ready, NULL) != 0)
+    {
+        LOG_ERROR("Could not watch the X connection.");
+        exit(EXIT_FAILURE);
+    }
+
+    // Block the handled signals, so they are delivered through a signalfd.
+    sigset_t signal_mask;
+    sigemptyset(&signal_mask);
+    int signal_count = sizeof(handled_signals) / sizeof(handled_signals[0]);
+    for (int i = 0; i < signal_count; i++)
+    {
+        sigaddset(&signal_mask, handled_signals[i]);
+    }
+    sigprocmask(SIG_BLOCK, &signal_mask, NULL);
+
+    // Watch the signals.
+    int signal_fd = signalfd(-1, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1 ||
+        register_event_source(signal_fd, EPOLLIN, handle_signal_ready, NULL) != 0)
+    {
+        LOG_ERROR("Could not watch signals.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void initialize_frame_timer()
+{
+    // Create a timer that expires at every frame deadline.
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        LOG_ERROR("Could not create frame timer.");
+        exit(EXIT_FAILURE);
+    }
+    long interval_ms = (throttle_ms > 0) ? (long)throttle_ms : 1;
+    struct timespec interval = {
+        .tv_sec = interval_ms / 1000,
+        .tv_nsec = (interval_ms % 1000) * 1000000L
+    };
+    struct itimerspec timer_spec = {
+        .it_interval = interval,
+        .it_value = interval
+    };
+    timerfd_settime(timer_fd, 0, &timer_spec, NULL);
+
+    // Watch the frame timer.
+    if (register_event_source(timer_fd, EPOLLIN, handle_timer_ready, NULL) != 0)
+    {
+        LOG_ERROR("Could not watch frame timer.");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void queue_x_events(Display *display)
+{
+    // Move the events read by Xlib into the priority queues.
+    while (XEventsQueued(display, QueuedAlready) > 0 && !is_event_queue_full())
+    {
+        // Retrieve the next X event.
+        XEvent x_event;
+        XNextEvent(display, &x_event);
+
+        // Downcast the X event to a standard event.
+        Event *event = (Event*)&x_event;
+        Event xinput_event;
+
+        // Check if the X event originated from the XInput2 extension, if it
+        // did, convert it to a more developer-friendly event type.
+        if (event->type == GenericEvent && event->xcookie.extension == xi_opcode)
+        {
+            // Extract the XInput2 event data.
+            XGenericEventCookie *cookie = &x_event.xcookie;
+            XGetEventData(display, cookie);
+            XIRawEvent *xi_raw_event = cookie->data;
+
+            // Skip non-raw XI2 input events. Active grabs (XIGrabKeycode)
+            // produce non-raw duplicates alongside the raw events we
+            // process. We only handle raw events in the pipeline.
+            if (xi_raw_event->evtype == XI_KeyPress ||
+                xi_raw_event->evtype == XI_KeyRelease ||
+                xi_raw_event->evtype == XI_ButtonPress ||
+                xi_raw_event->evtype == XI_ButtonRelease)
+            {
+                XFreeEventData(display, cookie);
+                continue;
+            }
+
+            // Construct a new event from the XInput2 event data.
+            xinput_event = convert_raw_xinput_event(xi_raw_event);
+            XFreeEventData(display, cookie);
+            event = &xinput_event;
+        }
+
+        push_event(event);
+    }
+}
+
+static uint64_t get_frame_deadline_us()
+{
+    // The deadline has already passed if an update is pending.
+    uint64_t now_us = get_monotonic_time_us();
+    if (update_pending) return now_us;
+
+    // Otherwise, the deadline is the next expiration of the frame timer.
+    struct itimerspec timer_spec;
+    if (timerfd_gettime(timer_fd, &timer_spec) == -1) return now_us;
+    return now_us +
+        (uint64_t)timer_spec.it_value.tv_sec * 1000000UL +
+        (uint64_t)timer_spec.it_value.tv_nsec / 1000UL;
+}
+
+static void process_x_events(Display *display)
+{
+    // Process events until the next frame deadline, so that an event storm
+    // can't starve the Update event, preventing compositor redraws and
+    // freezing the UI. A minimum budget guarantees progress.
+    uint64_t budget_end_us = get_frame_deadline_us();
+    uint64_t minimum_end_us = get_monotonic_time_us() + EVENT_MINIMUM_BUDGET_US;
+    if (budget_end_us < minimum_end_us) budget_end_us = minimum_end_us;
+
+    Event event;
+    while (true)
+    {
+        // Queue newly read events, allowing input to overtake other events.
+        queue_x_events(display);
+
+        // Call the appropriate event handlers of the highest priority event.
+        if (!pop_event(&event)) break;
+        record_event(&event);
+        call_event_handlers(&event);
+
+        // Stop once the budget is exhausted.
+        if (get_monotonic_time_us() >= budget_end_us) break;
+    }
+}
 
 void initialize_event_loop()
 {
@@ -22,8 +382,7 @@ void initialize_event_loop()
     Window root_window = DefaultRootWindow(display);
 
     // Retrieve the XInput2 extension opcode.
-    int xi_opcode;
-    if (!XQueryExtension(display, "XInputExtension", &xi_opcode, &(int){0}, &(int){0}))
+    if (!X_ROUND_TRIP(XQueryExtension, display, "XInputExtension", &xi_opcode, &(int){0}, &(int){0}))
     {
         LOG_ERROR("Could not retrieve opcode of XInput2 extension.");
         exit(EXIT_FAILURE);
@@ -33,101 +392,79 @@ void initialize_event_loop()
     XSelectInput(display, root_window, x_root_event_mask);
     xi_select_input(display, root_window, xi_root_event_mask);
 
+    // Set up the event sources, allowing modules to register their own.
+    initialize_event_sources(display);
+
     // Call all event handlers of the Prepare event.
     call_event_handlers((Event*)&(PrepareEvent){
         .type = Prepare
     });
 
+    // Load the requested event trace, creating its recorded windows before
+    // they are adopted.
+    if (is_event_replay_requested() && prepare_event_replay() != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+
     // Call all event handlers of the Initialize event.
     call_event_handlers((Event*)&(InitializeEvent){
         .type = Initialize
     });
 
-    while (true)
+    // Replay the requested event trace instead of handling X events.
+    if (is_event_replay_requested())
     {
-        // Calculate timeout to enforce minimum spacing between iterations.
-        Time current_time = x_get_current_time();
-        Time since_last_select = current_time - last_select_time;
-        Time remaining_time = (since_last_select < throttle_ms)
-            ? (throttle_ms - since_last_select)
-            : 0;
-        struct timeval timeout = {
-            .tv_sec = 0,
-            .tv_usec = remaining_time * 1000
-        };
-
-        // Block until an X event is received, or timeout.
-        fd_set read_fd_set;
-        FD_ZERO(&read_fd_set);
-        int display_fd = ConnectionNumber(display);
-        FD_SET(display_fd, &read_fd_set);
-        select(display_fd + 1, &read_fd_set, NULL, NULL, &timeout);
-
-        // Record when we woke up to enforce spacing on next iteration.
-        last_select_time = x_get_current_time();
-
-        // Process pending X events in batches. Without a limit, a flood of
-        // events (e.g., rapid mouse movement) could starve the Update event,
-        // preventing compositor redraws and freezing the UI.
-        int events_processed = 0;
-        const int max_events_per_iteration = 50;
-        while (XPending(display) > 0 && events_processed < max_events_per_iteration)
-        {
-            events_processed++;
+        exit(replay_events() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
 
-            // Retrieve the next X event.
-            XEvent x_event;
-            XNextEvent(display, &x_event);
+    // Start the frame timer, now that the framerate is known.
+    initialize_frame_timer();
 
-            // Downcast the X event to a standard event.
-            Event *event = (Event*)&x_event;
-            Event xinput_event;
+    struct epoll_event ready_events[MAX_EVENT_SOURCES];
+    while (true)
+    {
+        // Flush pending requests, as nothing else in the loop does so.
+        XFlush(display);
 
-            // Check if the X event originated from the XInput2 extension, if it
-            // did, convert it to a more developer-friendly event type.
-            if (event->type == GenericEvent && event->xcookie.extension == xi_opcode)
-            {
-                // Extract the XInput2 event data.
-                XGenericEventCookie *cookie = &x_event.xcookie;
-                XGetEventData(display, cookie);
-                XIRawEvent *xi_raw_event = cookie->data;
-
-                // Skip non-raw XI2 input events. Active grabs (XIGrabKeycode)
-                // produce non-raw duplicates alongside the raw events we
-                // process. We only handle raw events in the pipeline.
-                if (xi_raw_event->evtype == XI_KeyPress ||
-                    xi_raw_event->evtype == XI_KeyRelease ||
-                    xi_raw_event->evtype == XI_ButtonPress ||
-                    xi_raw_event->evtype == XI_ButtonRelease)
-                {
-                    XFreeEventData(display, cookie);
-                    continue;
-                }
-
-                // Construct a new event from the XInput2 event data.
-                xinput_event = convert_raw_xinput_event(xi_raw_event);
-                XFreeEventData(display, cookie);
-                event = &xinput_event;
-            }
+        // Block until an event source is ready. Events that Xlib already read
+        // into its queue (e.g. during a round trip) and events left over from
+        // the previous budget don't wake up epoll, so don't block on those.
+        bool events_queued = XEventsQueued(display, QueuedAlready) > 0 ||
+            !is_event_queue_empty();
+        int timeout = events_queued ? 0 : -1;
+        int ready_count = epoll_wait(epoll_fd, ready_events, MAX_EVENT_SOURCES, timeout);
+        if (ready_count == -1 && errno != EINTR)
+        {
+            LOG_ERROR("Could not wait for event sources.");
+            exit(EXIT_FAILURE);
+        }
+
+        TimelineSpan iteration_span = begin_timeline_span("loop", "iteration");
 
-            // Call the appropriate event handlers.
-            call_event_handlers(event);
+        // Call the callback of each ready event source.
+        for (int i = 0; i < ready_count; i++)
+        {
+            EventSource *source = ready_events[i].data.ptr;
+            if (!source->active) continue;
+            source->callback(source->fd, ready_events[i].events, source->data);
         }
 
-        // Get fresh time after processing events for accurate Update timing.
-        Time update_check_time = x_get_current_time();
+        // Process the queued X events.
+        process_x_events(display);
 
-        // Check if sufficient time has passed since the last update.
-        if (update_check_time - last_update_time >= throttle_ms)
+        // Check if the frame deadline has passed.
+        if (update_pending)
         {
-            // Call all event handlers of the Update event.
-            call_event_handlers((Event*)&(UpdateEvent){
-                .type = Update
-            });
+            update_pending = false;
 
-            // Update the last update time.
-            last_update_time = update_check_time;
+            // Call all event handlers of the Update event.
+            Event update_event = { .update = { .type = Update } };
+            record_event(&update_event);
+            call_event_handlers(&update_event);
         }
+
+        end_timeline_span(&iteration_span);
     }
 }
 
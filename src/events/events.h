@@ -137,11 +137,17 @@ typedef struct {
  * extension.
  * 
  * It bypasses X11's event mask ownership system, at the cost of losing out on 
- * all of the data typically provided with a traditional `MotionNotify` event.
+ * most of the data typically provided with a traditional `MotionNotify` event.
+ * 
+ * @note - The deltas are the accelerated X and Y valuator values of the source
+ * device, consecutive motion events of the same device are summed.
  */
 #define RawMotionNotify 141
 typedef struct {
     int type;
+    int device_id;
+    double delta_x;
+    double delta_y;
 } RawMotionNotifyEvent;
 
 /**
@@ -171,7 +177,8 @@ typedef struct {
 } RawKeyReleaseEvent;
 
 /**
- * An event that gets triggered when a portal receives focus.
+ * An event that gets triggered when a portal receives focus, or with a `NULL`
+ * portal when focus returns to the root window.
  */
 #define PortalFocused 144
 typedef struct {
@@ -200,6 +207,66 @@ typedef struct {
     int new_workspace;
 } PortalWorkspaceChangedEvent;
 
+/**
+ * An event that gets triggered when the tracked pointer position changes.
+ */
+#define PointerMoved 148
+typedef struct {
+    int type;
+    int x_root;
+    int y_root;
+} PointerMovedEvent;
+
+/**
+ * An event that gets triggered when the window manager receives a signal.
+ *
+ * @note - The event loop terminates the window manager after dispatching
+ * `SIGINT`, `SIGTERM` and `SIGHUP`, other signals are left to their handlers.
+ */
+#define SignalReceived 149
+typedef struct {
+    int type;
+    int signal;
+} SignalReceivedEvent;
+
+/**
+ * An event that gets triggered once existing windows have been adopted as
+ * portals at startup.
+ */
+#define PortalsAdopted 150
+typedef struct {
+    int type;
+    unsigned int adopted_count;
+} PortalsAdoptedEvent;
+
+/**
+ * An event that gets triggered when a batch of portal operations ends, see
+ * `begin_portal_batch()`.
+ */
+#define PortalBatchEnded 151
+typedef struct {
+    int type;
+} PortalBatchEndedEvent;
+
+/**
+ * An event that gets triggered when the compositor captured a new snapshot
+ * of a workspace, or with a workspace of -1 when it released all snapshots.
+ */
+#define WorkspaceSnapshotted 152
+typedef struct {
+    int type;
+    int workspace;
+} WorkspaceSnapshottedEvent;
+
+/**
+ * An event triggered when input devices are added, removed, enabled or
+ * disabled, provided by the XInput2 extension.
+ */
+#define RawHierarchyChanged 153
+typedef struct {
+    int type;
+} RawHierarchyChangedEvent;
+
 /**
  * A union of all possible event types that can be handled by the window
  * manager.
@@ -215,10 +282,12 @@ typedef union {
     PrepareEvent prepare;
     InitializeEvent initialize;
     UpdateEvent update;
+    SignalReceivedEvent signal_received;
 
     // Workspace events.
     WorkspaceSwitchedEvent workspace_switched;
     PortalWorkspaceChangedEvent portal_workspace_changed;
+    WorkspaceSnapshottedEvent workspace_snapshotted;
 
     // Portal events.
     PortalCreatedEvent portal_created;
@@ -229,6 +298,8 @@ typedef union {
     PortalRaisedEvent portal_raised;
     PortalTransformedEvent portal_transformed;
     PortalFocusedEvent portal_focused;
+    PortalsAdoptedEvent portals_adopted;
+    PortalBatchEndedEvent portal_batch_ended;
 
     // Shortcut events.
     ShortcutPressedEvent shortcut_pressed;
@@ -237,9 +308,13 @@ typedef union {
     RawButtonPressEvent raw_button_press;
     RawButtonReleaseEvent raw_button_release;
     RawMotionNotifyEvent raw_motion_notify;
+    RawHierarchyChangedEvent raw_hierarchy_changed;
     RawKeyPressEvent raw_key_press;
     RawKeyReleaseEvent raw_key_release;
 
+    // Pointer events.
+    PointerMovedEvent pointer_moved;
+
     // Xlib events.
     XAnyEvent xany;
     XKeyEvent xkey;
@@ -276,8 +351,58 @@ typedef union {
     XGenericEventCookie xcookie;
 } Event;
 
+/** The capacity of each event priority queue. */
+#define EVENT_QUEUE_CAPACITY 256
+
+/** The minimum time spent processing events per loop iteration. */
+#define EVENT_MINIMUM_BUDGET_US 1000
+
+/** The maximum number of file descriptors the event loop can watch. */
+#define MAX_EVENT_SOURCES 32
+
+/**
+ * Event source callback function signature.
+ *
+ * @param fd The file descriptor that became ready.
+ * @param events The ready epoll events (E.g. `EPOLLIN`).
+ * @param data The user data passed during registration.
+ */
+typedef void EventSourceCallback(int fd, uint32_t events, void *data);
+
+/**
+ * Registers a file descriptor to be watched by the event loop.
+ *
+ * @param fd The file descriptor to watch.
+ * @param events The epoll events to watch for (E.g. `EPOLLIN`).
+ * @param callback The callback function, called when the descriptor is ready.
+ * @param data The user data to pass to the callback function.
+ *
+ * @return - `0` - The file descriptor was registered successfully.
+ * @return - `-1` - The maximum number of event sources has been reached.
+ * @return - `-2` - The file descriptor could not be added to the epoll set.
+ *
+ * @note - Event sources may be registered from the `Prepare` event onwards.
+ */
+int register_event_source(int fd, uint32_t events, EventSourceCallback *callback, void *data);
+
+/**
+ * Unregisters a file descriptor that was watched by the event loop.
+ *
+ * @param fd The file descriptor to stop watching.
+ *
+ * @return - `0` - The file descriptor was unregistered successfully.
+ * @return - `-1` - The file descriptor was not registered.
+ *
+ * @note - The file descriptor is not closed by this function.
+ */
+int unregister_event_source(int fd);
+
 /**
  * Initiates an infinite event loop, handling X11/XInput2 events as they come 
  * in, and calling the appropriate registered event handlers.
+ * 
+ * @note - Events are dispatched by priority class: input first, then structure
+ * events (configure, map, etc.), then property and expose notifications. Each
+ * iteration is bounded by the next frame deadline rather than an event count.
  */
 void initialize_event_loop();
@@ -1,8 +1,12 @@
 #include "../all.h"
 
 typedef struct {
-    int type;
     EventCallback *callback;
+    EventHandlerSource source;
+    unsigned long calls;
+    unsigned long total_ns;
+    unsigned long max_ns;
+    unsigned long requests;
 } EventHandler;
 
 typedef struct {
@@ -11,45 +15,192 @@ typedef struct {
     int capacity;
 } EventHandlers;
 
-static EventHandlers event_handlers = {
-    .handlers = NULL,
-    .count = 0,
-    .capacity = 0,
-};
+/**
+ * The registered event handlers, grouped per event type so that dispatching
+ * an event is a direct index into a contiguous list of handlers.
+ */
+static EventHandlers event_handlers[MAX_EVENT_TYPES] = {{NULL, 0, 0}};
 
-void register_event_handler(int type, EventCallback *callback)
+/** The type of the event currently being dispatched, `-1` if none. */
+static int dispatching_event_type = -1;
+
+/**
+ * The time spent and X requests issued by the handlers of nested dispatches
+ * within the handler currently being called, so each handler is only charged
+ * for its own work.
+ */
+static uint64_t nested_ns = 0;
+static unsigned long nested_requests = 0;
+
+void register_event_handler(int type, EventHandlerSource source, EventCallback *callback)
 {
+    // Ensure the event type fits within the dispatch table.
+    if (type < 0 || type >= MAX_EVENT_TYPES)
+    {
+        LOG_ERROR("Event type %d exceeds the dispatch table.", type);
+        exit(EXIT_FAILURE);
+    }
+    EventHandlers *handlers = &event_handlers[type];
+
     // Allocate additional memory for the event handlers if necessary.
-    if (event_handlers.count >= event_handlers.capacity)
+    if (handlers->count >= handlers->capacity)
     {
-        int new_capacity = event_handlers.capacity == 0 ? 2 : event_handlers.capacity * 2;
-        EventHandler *handlers = realloc(event_handlers.handlers, new_capacity * sizeof(EventHandler));
-        if (handlers == NULL)
+        int new_capacity = handlers->capacity == 0 ? 2 : handlers->capacity * 2;
+        EventHandler *new_handlers = realloc(handlers->handlers, new_capacity * sizeof(EventHandler));
+        if (new_handlers == NULL)
         {
             LOG_ERROR("Failed to allocate memory for event handlers.");
             exit(EXIT_FAILURE);
         }
-        event_handlers.handlers = handlers;
-        event_handlers.capacity = new_capacity;
+        handlers->handlers = new_handlers;
+        handlers->capacity = new_capacity;
     }
 
     // Register the event handler.
-    event_handlers.handlers[event_handlers.count] = (EventHandler){
-        .type = type,
+    handlers->handlers[handlers->count] = (EventHandler){
         .callback = callback,
+        .source = source,
     };
-    event_handlers.count++;
+    handlers->count++;
 }
 
 void call_event_handlers(Event *event)
 {
-    // Iterate through all event handlers, calling the callback of each event
-    // handler that has a matching event type.
-    for (int i = 0; i < event_handlers.count; i++)
+    // Ignore event types outside of the dispatch table.
+    if (event->type < 0 || event->type >= MAX_EVENT_TYPES) return;
+    EventHandlers *handlers = &event_handlers[event->type];
+    Display *display = DefaultDisplay;
+
+    // Keep track of the event type, restoring it after nested dispatches.
+    int previous_event_type = dispatching_event_type;
+    dispatching_event_type = event->type;
+
+    // Call the callback of each event handler registered for the event type,
+    // accounting for the time spent and the X requests issued.
+    for (int i = 0; i < handlers->count; i++)
     {
-        if (event_handlers.handlers[i].type == event->type)
+        EventHandler *handler = &handlers->handlers[i];
+        unsigned long start_request = (display != NULL) ? NextRequest(display) : 0;
+        uint64_t start_ns = get_monotonic_time_ns();
+        TimelineSpan span = begin_timeline_span("handler", handler->source.type_name);
+        span.file = handler->source.file;
+        span.line = handler->source.line;
+
+        // Reset the nested accounting, restoring it for the enclosing handler.
+        uint64_t outer_nested_ns = nested_ns;
+        unsigned long outer_nested_requests = nested_requests;
+        nested_ns = 0;
+        nested_requests = 0;
+
+        handler->callback(event);
+
+        end_timeline_span(&span);
+        uint64_t elapsed_ns = get_monotonic_time_ns() - start_ns;
+        unsigned long elapsed_requests = (display != NULL)
+            ? NextRequest(display) - start_request
+            : 0;
+
+        // Charge the handler only for the work outside of nested dispatches.
+        uint64_t exclusive_ns = elapsed_ns - nested_ns;
+        handler->calls++;
+        handler->total_ns += exclusive_ns;
+        if (exclusive_ns > handler->max_ns) handler->max_ns = exclusive_ns;
+        handler->requests += elapsed_requests - nested_requests;
+
+        // Charge the whole handler as nested work to the enclosing handler.
+        nested_ns = outer_nested_ns + elapsed_ns;
+        nested_requests = outer_nested_requests + elapsed_requests;
+    }
+
+    dispatching_event_type = previous_event_type;
+}
+
+int get_dispatching_event_type()
+{
+    return dispatching_event_type;
+}
+
+const char *get_event_type_name(int type)
+{
+    if (type < 0 || type >= MAX_EVENT_TYPES) return NULL;
+    if (event_handlers[type].count == 0) return NULL;
+    return event_handlers[type].handlers[0].source.type_name;
+}
+
+static int compare_handler_total_time(const void *a, const void *b)
+{
+    const EventHandler *handler_a = *(const EventHandler **)a;
+    const EventHandler *handler_b = *(const EventHandler **)b;
+    if (handler_a->total_ns == handler_b->total_ns) return 0;
+    return (handler_a->total_ns < handler_b->total_ns) ? 1 : -1;
+}
+
+void report_event_handler_profile()
+{
+    // Collect the handlers that have been called at least once.
+    int handler_count = 0;
+    for (int type = 0; type < MAX_EVENT_TYPES; type++)
+    {
+        handler_count += event_handlers[type].count;
+    }
+    if (handler_count == 0) return;
+    EventHandler **called = malloc(handler_count * sizeof(EventHandler *));
+    if (called == NULL) return;
+    int called_count = 0;
+    for (int type = 0; type < MAX_EVENT_TYPES; type++)
+    {
+        for (int i = 0; i < event_handlers[type].count; i++)
         {
-            event_handlers.handlers[i].callback(event);
+            EventHandler *handler = &event_handlers[type].handlers[i];
+            if (handler->calls == 0) continue;
+            called[called_count++] = handler;
         }
     }
+
+    // Sort the handlers by the total time spent, most expensive first.
+    qsort(called, called_count, sizeof(EventHandler *), compare_handler_total_time);
+
+    // Print the report.
+    fprintf(stderr,
+        "%-24s %-32s %10s %12s %10s %10s %10s\n",
+        "EVENT", "LOCATION", "CALLS", "TOTAL (ms)", "AVG (us)", "MAX (us)", "REQUESTS"
+    );
+    for (int i = 0; i < called_count; i++)
+    {
+        EventHandler *handler = called[i];
+        char location[COMMON_MAX_PATH_LENGTH];
+        snprintf(location, sizeof(location), "%s:%d", handler->source.file, handler->source.line);
+        fprintf(stderr,
+            "%-24s %-32s %10lu %12.3f %10.1f %10.1f %10lu\n",
+            handler->source.type_name,
+            location,
+            handler->calls,
+            handler->total_ns / 1000000.0,
+            handler->total_ns / 1000.0 / handler->calls,
+            handler->max_ns / 1000.0,
+            handler->requests
+        );
+    }
+
+    free(called);
+}
+
+HANDLE(Initialize)
+{
+    // Report the handler profile, round trips and startup adoption when the
+    // window manager exits.
+    atexit(x_report_round_trips);
+    atexit(report_event_handler_profile);
+    atexit(report_portal_adoption);
+}
+
+HANDLE(SignalReceived)
+{
+    SignalReceivedEvent *_event = &event->signal_received;
+
+    // Report the handler profile, round trips and startup adoption on demand.
+    if (_event->signal != SIGUSR1) return;
+    report_portal_adoption();
+    report_event_handler_profile();
+    x_report_round_trips();
 }
@@ -9,20 +9,25 @@
  * event handler callback function.
  * 
  * It then defines the implementations of these two functions: the registration 
- * function registers the event handler, and the event handler callback function
- * is left empty, to be filled in by the user.
+ * function registers the event handler along with its source location, and the
+ * event handler callback function is left empty, to be filled in by the user.
  * 
  * @param type The event type.
+ * @param type_name The event type name.
  * @param count The counter value.
  * 
  * @warning Don't use directly! Use the `HANDLE()` macro instead.
  */
-#define HANDLE_IMPLEMENTATION(type, count) \
+#define HANDLE_IMPLEMENTATION(type, type_name, count) \
     static void register_handler_##type##_##count() __attribute__((constructor)); \
     static void handler_##type##_##count(__attribute__((unused)) Event *event); \
     static void register_handler_##type##_##count() \
     { \
-        register_event_handler(type, &handler_##type##_##count); \
+        register_event_handler( \
+            type, \
+            (EventHandlerSource){ type_name, __FILE__, __LINE__ }, \
+            &handler_##type##_##count \
+        ); \
     } \
     static void handler_##type##_##count(__attribute__((unused)) Event *event)
 
@@ -33,11 +38,13 @@
  * It adds the `count` parameter, used to prevent naming collisions.
  * 
  * @param type The event type.
+ * @param type_name The event type name.
  * @param count The counter value.
  * 
  * @warning Don't use directly! Use the `HANDLE()` macro instead.
  */
-#define HANDLE_EXPANDED(type, count) HANDLE_IMPLEMENTATION(type, count)
+#define HANDLE_EXPANDED(type, type_name, count) \
+    HANDLE_IMPLEMENTATION(type, type_name, count)
 
 /**
  * A macro that simplifies the process of creating and registering event
@@ -45,7 +52,13 @@
  * 
  * @param type The event type.
  */
-#define HANDLE(type) HANDLE_EXPANDED(type, __COUNTER__)
+#define HANDLE(type) HANDLE_EXPANDED(type, #type, __COUNTER__)
+
+/**
+ * The size of the event dispatch table, covering both the core X11 event types
+ * and the custom event types.
+ */
+#define MAX_EVENT_TYPES 256
 
 /**
  * Event handler callback function signature.
@@ -54,20 +67,67 @@
  */
 typedef void EventCallback(Event *event);
 
+/**
+ * The source of an event handler, used to identify it in profiling reports.
+ */
+typedef struct {
+    const char *type_name;
+    const char *file;
+    int line;
+} EventHandlerSource;
+
 /**
  * Registers an event handler for a given event type.
  * 
  * @param type The event type.
+ * @param source The source of the event handler.
  * @param callback The event handler callback function.
  * 
  * @warning Don't use directly! Use the `HANDLE()` macro instead.
+ * @warning The event type must be lower than `MAX_EVENT_TYPES`.
  */
-void register_event_handler(int type, EventCallback *callback);
+void register_event_handler(int type, EventHandlerSource source, EventCallback *callback);
 
 /**
  * Calls all registered event handler callback functions for a given event type.
  * 
  * @param event The event structure, where the `type` field is used to determine
  * which event handlers to call.
+ * 
+ * @note - Handlers are stored per event type, so the cost of a dispatch only 
+ * depends on the amount of handlers registered for that event type.
+ * @note - Each handler call is accounted for in the handler profile, see
+ * `report_event_handler_profile()`.
  */
 void call_event_handlers(Event *event);
+
+/**
+ * Retrieves the type of the event currently being dispatched.
+ * 
+ * @return - `>= 0` - The type of the innermost event being dispatched.
+ * @return - `-1` - No event is being dispatched.
+ */
+int get_dispatching_event_type();
+
+/**
+ * Retrieves the name of an event type, as written in its `HANDLE()` macros.
+ * 
+ * @param type The event type.
+ * 
+ * @return - `const char*` - The name of the event type.
+ * @return - `NULL` - No handler is registered for the event type.
+ */
+const char *get_event_type_name(int type);
+
+/**
+ * Prints the accumulated cost of each event handler to `stderr`, sorted by
+ * the total time spent in the handler.
+ * 
+ * The report lists the call count, total, average and maximum wall time, and 
+ * the number of X requests issued by each handler. Time and requests spent in
+ * the handlers of events fired from within a handler are excluded from it.
+ * 
+ * @note - The report is printed automatically at exit, and when the window 
+ * manager receives `SIGUSR1`.
+ */
+void report_event_handler_profile();
@@ -0,0 +1,1061 @@
+/**
+ * This code is responsible for recording the events dispatched by the event
+ * loop to a binary event trace, and replaying such a trace. Replaying a trace
+ * captured on a user's machine against a virtual X server (e.g. Xvfb) allows
+ * measuring handler and compositor throughput on real-world sessions.
+ */
+
+#include "../all.h"
+
+/** Marks a stand-in window as destroyed in the replay window map. */
+#define STAND_IN_DESTROYED (1u << 31)
+
+typedef struct {
+    uint32_t key;                    // `0` if the slot is empty.
+    uint32_t flags;
+    unsigned long value;
+} TraceMapEntry;
+
+/**
+ * An open-addressing hash table (linear probing) mapping recorded IDs to the
+ * IDs they stand for. Entries are never removed, the maps only live as long
+ * as the recording or replay.
+ */
+typedef struct {
+    TraceMapEntry *entries;
+    unsigned int capacity;           // Always a power of two.
+    unsigned int count;
+} TraceMap;
+
+/** The payload of any recorded event. */
+typedef union {
+    EventTraceWindow window;
+    EventTraceStructure structure;
+    EventTraceConfigure configure;
+    EventTraceExpose expose;
+    EventTraceFocus focus;
+    EventTraceProperty property;
+    EventTraceClientMessage client_message;
+    EventTraceRawInput raw_input;
+    EventTraceRawMotion raw_motion;
+} EventTracePayload;
+
+static FILE *trace_file = NULL;
+static uint64_t trace_last_us = 0;
+static TraceMap recorded_atoms = {NULL, 0, 0};
+static char replay_path[COMMON_MAX_PATH_LENGTH] = "";
+static char replay_budget_path[COMMON_MAX_PATH_LENGTH] = "";
+static uint8_t *replay_data = NULL;
+static size_t replay_size = 0;
+static TraceMap replay_windows = {NULL, 0, 0};
+static TraceMap replay_atoms = {NULL, 0, 0};
+
+static unsigned int hash_trace_id(uint32_t id)
+{
+    // IDs share their high (client) bits, so spread the low bits with a
+    // Fibonacci multiplicative hash.
+    return (unsigned int)(((uint64_t)id * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static TraceMapEntry *find_trace_map_entry(TraceMap *map, uint32_t key)
+{
+    if (map->capacity == 0 || key == 0) return NULL;
+
+    // Probe from the home slot until the key or an empty slot is found.
+    unsigned int mask = map->capacity - 1;
+    for (unsigned int i = hash_trace_id(key) & mask;; i = (i + 1) & mask)
+    {
+        TraceMapEntry *entry = &map->entries[i];
+        if (entry->key == key) return entry;
+        if (entry->key == 0) return NULL;
+    }
+}
+
+static TraceMapEntry *insert_trace_map_entry(TraceMap *map, uint32_t key)
+{
+    if (key == 0) return NULL;
+
+    // Keep the load factor at or below one half, so probes stay short.
+    if ((map->count + 1) * 2 > map->capacity)
+    {
+        unsigned int new_capacity = (map->capacity == 0)
+            ? EVENT_TRACE_MAP_INITIAL_CAPACITY
+            : map->capacity * 2;
+        TraceMapEntry *new_entries = calloc(new_capacity, sizeof(TraceMapEntry));
+        if (new_entries == NULL) return NULL;
+
+        // Rehash the existing entries into the new slot array.
+        TraceMap old_map = *map;
+        *map = (TraceMap){new_entries, new_capacity, 0};
+        for (unsigned int i = 0; i < old_map.capacity; i++)
+        {
+            if (old_map.entries[i].key == 0) continue;
+            *insert_trace_map_entry(map, old_map.entries[i].key) = old_map.entries[i];
+        }
+        free(old_map.entries);
+    }
+
+    // Probe from the home slot until the key or an empty slot is found.
+    unsigned int mask = map->capacity - 1;
+    for (unsigned int i = hash_trace_id(key) & mask;; i = (i + 1) & mask)
+    {
+        TraceMapEntry *entry = &map->entries[i];
+        if (entry->key == key) return entry;
+        if (entry->key == 0)
+        {
+            *entry = (TraceMapEntry){.key = key};
+            map->count++;
+            return entry;
+        }
+    }
+}
+
+static void free_trace_map(TraceMap *map)
+{
+    free(map->entries);
+    *map = (TraceMap){NULL, 0, 0};
+}
+
+static void close_event_trace()
+{
+    if (trace_file == NULL) return;
+    fclose(trace_file);
+    trace_file = NULL;
+    free_trace_map(&recorded_atoms);
+}
+
+void request_event_replay(const char *path, const char *budget_path)
+{
+    snprintf(replay_path, sizeof(replay_path), "%s", path);
+    snprintf(
+        replay_budget_path, sizeof(replay_budget_path),
+        "%s", (budget_path != NULL) ? budget_path : ""
+    );
+}
+
+bool is_event_replay_requested()
+{
+    return replay_path[0] != '\0';
+}
+
+static void write_trace_record(int type, const void *payload, size_t size)
+{
+    if (trace_file == NULL) return;
+
+    // Store the time since the previous record, which keeps records small.
+    uint64_t now_us = get_monotonic_time_us();
+    uint64_t delay_us = now_us - trace_last_us;
+    trace_last_us = now_us;
+
+    // Append the record header followed by its payload.
+    EventTraceRecord record = {
+        .delay_us = (delay_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)delay_us,
+        .type = (uint16_t)type,
+        .size = (uint16_t)size
+    };
+    if (fwrite(&record, sizeof(record), 1, trace_file) != 1 ||
+        (size > 0 && fwrite(payload, size, 1, trace_file) != 1))
+    {
+        LOG_WARNING("Failed to write event trace, recording stopped.");
+        close_event_trace();
+    }
+}
+
+static uint32_t encode_window(Window window)
+{
+    if (window == None) return 0;
+    if (window == DefaultRootWindow(DefaultDisplay)) return EVENT_TRACE_ROOT_WINDOW;
+
+    // Frame windows are created by the replaying window manager itself, so
+    // refer to them through their client window.
+    PortalWindowRole role;
+    Portal *portal = lookup_portal_window(window, &role);
+    if (portal != NULL && role == PORTAL_WINDOW_FRAME && portal->client_window != None)
+    {
+        return EVENT_TRACE_FRAME_WINDOW | (uint32_t)portal->client_window;
+    }
+    return (uint32_t)window;
+}
+
+static uint32_t encode_atom(Atom atom)
+{
+    if (atom == None) return 0;
+
+    // Name the atom the first time it appears, atom IDs differ between
+    // X servers.
+    if (find_trace_map_entry(&recorded_atoms, (uint32_t)atom) != NULL) return (uint32_t)atom;
+    char *name = X_ROUND_TRIP(XGetAtomName, DefaultDisplay, atom);
+    if (name == NULL) return 0;
+    size_t length = strlen(name);
+    if (length > UINT16_MAX - sizeof(EventTraceAtom)) length = UINT16_MAX - sizeof(EventTraceAtom);
+    uint8_t payload[sizeof(EventTraceAtom) + UINT16_MAX];
+    memcpy(payload, &(EventTraceAtom){.atom = (uint32_t)atom}, sizeof(EventTraceAtom));
+    memcpy(payload + sizeof(EventTraceAtom), name, length);
+    XFree(name);
+    write_trace_record(EVENT_TRACE_ATOM, payload, sizeof(EventTraceAtom) + length);
+    insert_trace_map_entry(&recorded_atoms, (uint32_t)atom);
+
+    return (uint32_t)atom;
+}
+
+static size_t encode_event(Event *event, EventTracePayload *payload)
+{
+    // Zero the payload, so no uninitialized padding is written.
+    memset(payload, 0, sizeof(*payload));
+
+    switch (event->type)
+    {
+        case CreateNotify:
+        {
+            XCreateWindowEvent *_event = &event->xcreatewindow;
+            payload->window = (EventTraceWindow){
+                .window = encode_window(_event->window),
+                .parent = encode_window(_event->parent),
+                .x = _event->x, .y = _event->y,
+                .width = _event->width, .height = _event->height,
+                .border_width = _event->border_width,
+                .flags = _event->override_redirect ? EVENT_TRACE_OVERRIDE_REDIRECT : 0
+            };
+            return sizeof(EventTraceWindow);
+        }
+        case DestroyNotify:
+        {
+            XDestroyWindowEvent *_event = &event->xdestroywindow;
+            payload->structure.event = encode_window(_event->event);
+            payload->structure.window = encode_window(_event->window);
+            return sizeof(EventTraceStructure);
+        }
+        case UnmapNotify:
+        {
+            XUnmapEvent *_event = &event->xunmap;
+            payload->structure.event = encode_window(_event->event);
+            payload->structure.window = encode_window(_event->window);
+            payload->structure.flags =
+                (_event->send_event ? EVENT_TRACE_SEND_EVENT : 0) |
+                (_event->from_configure ? EVENT_TRACE_FROM_CONFIGURE : 0);
+            return sizeof(EventTraceStructure);
+        }
+        case MapNotify:
+        {
+            XMapEvent *_event = &event->xmap;
+            payload->structure.event = encode_window(_event->event);
+            payload->structure.window = encode_window(_event->window);
+            payload->structure.flags =
+                (_event->override_redirect ? EVENT_TRACE_OVERRIDE_REDIRECT : 0);
+            return sizeof(EventTraceStructure);
+        }
+        case MapRequest:
+        {
+            XMapRequestEvent *_event = &event->xmaprequest;
+            payload->structure.event = encode_window(_event->parent);
+            payload->structure.window = encode_window(_event->window);
+            return sizeof(EventTraceStructure);
+        }
+        case ReparentNotify:
+        {
+            XReparentEvent *_event = &event->xreparent;
+            payload->structure = (EventTraceStructure){
+                .event = encode_window(_event->event),
+                .window = encode_window(_event->window),
+                .parent = encode_window(_event->parent),
+                .x = _event->x, .y = _event->y,
+                .flags = _event->override_redirect ? EVENT_TRACE_OVERRIDE_REDIRECT : 0
+            };
+            return sizeof(EventTraceStructure);
+        }
+        case CirculateNotify:
+        {
+            XCirculateEvent *_event = &event->xcirculate;
+            payload->structure.event = encode_window(_event->event);
+            payload->structure.window = encode_window(_event->window);
+            payload->structure.detail = _event->place;
+            return sizeof(EventTraceStructure);
+        }
+        case ConfigureNotify:
+        {
+            XConfigureEvent *_event = &event->xconfigure;
+            payload->configure = (EventTraceConfigure){
+                .event = encode_window(_event->event),
+                .window = encode_window(_event->window),
+                .above = encode_window(_event->above),
+                .x = _event->x, .y = _event->y,
+                .width = _event->width, .height = _event->height,
+                .border_width = _event->border_width,
+                .flags =
+                    (_event->override_redirect ? EVENT_TRACE_OVERRIDE_REDIRECT : 0) |
+                    (_event->send_event ? EVENT_TRACE_SEND_EVENT : 0)
+            };
+            return sizeof(EventTraceConfigure);
+        }
+        case ConfigureRequest:
+        {
+            XConfigureRequestEvent *_event = &event->xconfigurerequest;
+            payload->configure = (EventTraceConfigure){
+                .event = encode_window(_event->parent),
+                .window = encode_window(_event->window),
+                .above = encode_window(_event->above),
+                .x = _event->x, .y = _event->y,
+                .width = _event->width, .height = _event->height,
+                .border_width = _event->border_width,
+                .detail = _event->detail,
+                .value_mask = (uint32_t)_event->value_mask
+            };
+            return sizeof(EventTraceConfigure);
+        }
+        case Expose:
+        {
+            XExposeEvent *_event = &event->xexpose;
+            payload->expose = (EventTraceExpose){
+                .window = encode_window(_event->window),
+                .x = _event->x, .y = _event->y,
+                .width = _event->width, .height = _event->height,
+                .count = _event->count
+            };
+            return sizeof(EventTraceExpose);
+        }
+        case FocusIn:
+        {
+            XFocusChangeEvent *_event = &event->xfocus;
+            payload->focus.window = encode_window(_event->window);
+            payload->focus.mode = _event->mode;
+            payload->focus.detail = _event->detail;
+            return sizeof(EventTraceFocus);
+        }
+        case PropertyNotify:
+        {
+            XPropertyEvent *_event = &event->xproperty;
+            payload->property.window = encode_window(_event->window);
+            payload->property.atom = encode_atom(_event->atom);
+            payload->property.state = _event->state;
+            return sizeof(EventTraceProperty);
+        }
+        case ClientMessage:
+        {
+            XClientMessageEvent *_event = &event->xclient;
+            EventTraceClientMessage *message = &payload->client_message;
+            message->window = encode_window(_event->window);
+            message->message_type = encode_atom(_event->message_type);
+            message->format = _event->format;
+            if (_event->format == 32)
+            {
+                for (int i = 0; i < 5; i++) message->data[i] = (uint32_t)_event->data.l[i];
+
+                // The properties to alter of _NET_WM_STATE messages are atoms.
+                if (_event->message_type == ATOM(_NET_WM_STATE))
+                {
+                    message->data[1] = encode_atom(_event->data.l[1]);
+                    message->data[2] = encode_atom(_event->data.l[2]);
+                }
+            }
+            else
+            {
+                memcpy(message->data, _event->data.b, sizeof(message->data));
+            }
+            return sizeof(EventTraceClientMessage);
+        }
+        case RawButtonPress:
+        case RawButtonRelease:
+            payload->raw_input.detail = event->raw_button_press.button;
+            return sizeof(EventTraceRawInput);
+        case RawKeyPress:
+        case RawKeyRelease:
+            payload->raw_input.detail = event->raw_key_press.key_code;
+            return sizeof(EventTraceRawInput);
+        case RawMotionNotify:
+            payload->raw_motion.delta_x = event->raw_motion_notify.delta_x;
+            payload->raw_motion.delta_y = event->raw_motion_notify.delta_y;
+            payload->raw_motion.device_id = event->raw_motion_notify.device_id;
+            return sizeof(EventTraceRawMotion);
+        case RawHierarchyChanged:
+        case Update:
+            return 0;
+        default:
+            return SIZE_MAX;
+    }
+}
+
+void record_event(Event *event)
+{
+    if (trace_file == NULL) return;
+
+    // Encode the event, skipping event types the window manager doesn't handle.
+    EventTracePayload payload;
+    size_t size = encode_event(event, &payload);
+    if (size == SIZE_MAX) return;
+
+    write_trace_record(event->type, &payload, size);
+}
+
+static void record_existing_windows()
+{
+    Display *display = DefaultDisplay;
+    Window root_window = DefaultRootWindow(display);
+
+    // Query all children of the root window (bottom-to-top stacking order).
+    Window *children = NULL;
+    unsigned int child_count = 0;
+    if (!X_ROUND_TRIP(XQueryTree, display, root_window, &(Window){0}, &(Window){0}, &children, &child_count))
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < child_count; i++)
+    {
+        XWindowAttributes attrs;
+        if (!X_ROUND_TRIP(XGetWindowAttributes, display, children[i], &attrs)) continue;
+
+        // Record the windows as they were before being adopted, as they may
+        // already have been depending on the order of the `Initialize`
+        // handlers. Adopted windows were viewable, and framed ones are
+        // recorded as their client window at its position within the frame.
+        PortalWindowRole role;
+        Portal *portal = lookup_portal_window(children[i], &role);
+        Window window = children[i];
+        if (portal != NULL && role == PORTAL_WINDOW_FRAME)
+        {
+            XWindowAttributes client_attrs;
+            window = portal->client_window;
+            if (window == None) continue;
+            if (!X_ROUND_TRIP(XGetWindowAttributes, display, window, &client_attrs)) continue;
+            client_attrs.x += attrs.x;
+            client_attrs.y += attrs.y;
+            attrs = client_attrs;
+        }
+
+        // Skip the other windows owned by this WM process.
+        if (portal == NULL && x_get_window_pid(display, window) == getpid()) continue;
+
+        bool mapped = (portal != NULL || attrs.map_state != IsUnmapped);
+        EventTraceWindow record = {
+            .window = (uint32_t)window,
+            .parent = EVENT_TRACE_ROOT_WINDOW,
+            .x = attrs.x, .y = attrs.y,
+            .width = attrs.width, .height = attrs.height,
+            .border_width = attrs.border_width,
+            .flags =
+                (attrs.override_redirect ? EVENT_TRACE_OVERRIDE_REDIRECT : 0) |
+                (mapped ? EVENT_TRACE_MAPPED : 0)
+        };
+        write_trace_record(EVENT_TRACE_WINDOW, &record, sizeof(record));
+    }
+
+    if (children != NULL) XFree(children);
+}
+
+static Window decode_window(uint32_t window)
+{
+    if (window == 0) return None;
+    if (window == EVENT_TRACE_ROOT_WINDOW) return DefaultRootWindow(DefaultDisplay);
+
+    // Resolve frame windows through the portal of their client window.
+    if (window & EVENT_TRACE_FRAME_WINDOW)
+    {
+        Portal *portal = find_portal_by_window(decode_window(window & ~EVENT_TRACE_FRAME_WINDOW));
+        return (portal != NULL) ? portal->frame_window : None;
+    }
+
+    // Resolve client windows to their stand-in windows.
+    TraceMapEntry *entry = find_trace_map_entry(&replay_windows, window);
+    return (entry != NULL) ? (Window)entry->value : None;
+}
+
+static Atom decode_atom(uint32_t atom)
+{
+    TraceMapEntry *entry = find_trace_map_entry(&replay_atoms, atom);
+    return (entry != NULL) ? (Atom)entry->value : None;
+}
+
+static void create_stand_in_window(const EventTraceWindow *record)
+{
+    Display *display = DefaultDisplay;
+
+    // Only client windows get a stand-in, and only once.
+    if (record->window == 0) return;
+    if (record->window & (EVENT_TRACE_ROOT_WINDOW | EVENT_TRACE_FRAME_WINDOW)) return;
+    Window parent = decode_window(record->parent);
+    if (parent == None) return;
+    TraceMapEntry *entry = insert_trace_map_entry(&replay_windows, record->window);
+    if (entry == NULL || entry->value != None) return;
+
+    // Create the stand-in window with the recorded geometry.
+    XSetWindowAttributes attributes = {
+        .override_redirect = (record->flags & EVENT_TRACE_OVERRIDE_REDIRECT) != 0,
+        .background_pixel = WhitePixel(display, DefaultScreen(display))
+    };
+    Window window = XCreateWindow(
+        display, parent,
+        record->x, record->y,
+        common.int_max(1, record->width), common.int_max(1, record->height),
+        record->border_width, CopyFromParent, InputOutput, CopyFromParent,
+        CWOverrideRedirect | CWBackPixel, &attributes
+    );
+    entry->value = window;
+    entry->flags = record->flags & EVENT_TRACE_OVERRIDE_REDIRECT;
+    if (record->flags & EVENT_TRACE_MAPPED) XMapWindow(display, window);
+}
+
+/**
+ * Applies the change a client made to a window before the event reporting it
+ * is dispatched, so the stand-in window reflects it. Only the unmanaged
+ * (override-redirect) windows are moved, mapped and unmapped, as the window
+ * manager does so itself for the managed ones.
+ */
+static void mirror_client_change(int type, const EventTracePayload *payload)
+{
+    Display *display = DefaultDisplay;
+
+    switch (type)
+    {
+        case CreateNotify:
+            create_stand_in_window(&payload->window);
+            return;
+        case DestroyNotify:
+        case MapNotify:
+        case UnmapNotify:
+        {
+            TraceMapEntry *entry = find_trace_map_entry(&replay_windows, payload->structure.window);
+            if (entry == NULL || (entry->flags & STAND_IN_DESTROYED)) return;
+            Window window = (Window)entry->value;
+            if (type == DestroyNotify)
+            {
+                // Keep the stand-in mapped, so the event still refers to it.
+                XDestroyWindow(display, window);
+                entry->flags |= STAND_IN_DESTROYED;
+                return;
+            }
+            if (!(entry->flags & EVENT_TRACE_OVERRIDE_REDIRECT)) return;
+            if (payload->structure.flags & EVENT_TRACE_SEND_EVENT) return;
+            if (type == MapNotify) XMapWindow(display, window);
+            else XUnmapWindow(display, window);
+            return;
+        }
+        case ConfigureNotify:
+        {
+            TraceMapEntry *entry = find_trace_map_entry(&replay_windows, payload->configure.window);
+            if (entry == NULL || (entry->flags & STAND_IN_DESTROYED)) return;
+            if (!(entry->flags & EVENT_TRACE_OVERRIDE_REDIRECT)) return;
+            if (payload->configure.flags & EVENT_TRACE_SEND_EVENT) return;
+            XMoveResizeWindow(
+                display, (Window)entry->value,
+                payload->configure.x, payload->configure.y,
+                common.int_max(1, payload->configure.width),
+                common.int_max(1, payload->configure.height)
+            );
+            return;
+        }
+    }
+}
+
+static bool decode_event(int type, const EventTracePayload *payload, Event *event)
+{
+    Display *display = DefaultDisplay;
+    memset(event, 0, sizeof(*event));
+    event->type = type;
+    uint32_t flags = 0;
+    Window subject = None;           // The window the event is about.
+
+    // Core X events are treated as generated after all requests issued so far.
+    if (type < LASTEvent)
+    {
+        event->xany.display = display;
+        event->xany.serial = NextRequest(display) - 1;
+    }
+
+    switch (type)
+    {
+        case CreateNotify:
+        {
+            XCreateWindowEvent *_event = &event->xcreatewindow;
+            _event->window = decode_window(payload->window.window);
+            subject = _event->window;
+            _event->parent = decode_window(payload->window.parent);
+            _event->x = payload->window.x;
+            _event->y = payload->window.y;
+            _event->width = payload->window.width;
+            _event->height = payload->window.height;
+            _event->border_width = payload->window.border_width;
+            _event->override_redirect = (payload->window.flags & EVENT_TRACE_OVERRIDE_REDIRECT) != 0;
+            break;
+        }
+        case DestroyNotify:
+            event->xdestroywindow.event = decode_window(payload->structure.event);
+            event->xdestroywindow.window = decode_window(payload->structure.window);
+            subject = event->xdestroywindow.window;
+            break;
+        case UnmapNotify:
+            flags = payload->structure.flags;
+            event->xunmap.event = decode_window(payload->structure.event);
+            event->xunmap.window = decode_window(payload->structure.window);
+            subject = event->xunmap.window;
+            event->xunmap.from_configure = (flags & EVENT_TRACE_FROM_CONFIGURE) != 0;
+            break;
+        case MapNotify:
+            event->xmap.event = decode_window(payload->structure.event);
+            event->xmap.window = decode_window(payload->structure.window);
+            subject = event->xmap.window;
+            event->xmap.override_redirect = (payload->structure.flags & EVENT_TRACE_OVERRIDE_REDIRECT) != 0;
+            break;
+        case MapRequest:
+            event->xmaprequest.parent = decode_window(payload->structure.event);
+            event->xmaprequest.window = decode_window(payload->structure.window);
+            subject = event->xmaprequest.window;
+            break;
+        case ReparentNotify:
+        {
+            XReparentEvent *_event = &event->xreparent;
+            _event->event = decode_window(payload->structure.event);
+            _event->window = decode_window(payload->structure.window);
+            subject = _event->window;
+            _event->parent = decode_window(payload->structure.parent);
+            _event->x = payload->structure.x;
+            _event->y = payload->structure.y;
+            _event->override_redirect = (payload->structure.flags & EVENT_TRACE_OVERRIDE_REDIRECT) != 0;
+            break;
+        }
+        case CirculateNotify:
+            event->xcirculate.event = decode_window(payload->structure.event);
+            event->xcirculate.window = decode_window(payload->structure.window);
+            subject = event->xcirculate.window;
+            event->xcirculate.place = payload->structure.detail;
+            break;
+        case ConfigureNotify:
+        {
+            XConfigureEvent *_event = &event->xconfigure;
+            flags = payload->configure.flags;
+            _event->event = decode_window(payload->configure.event);
+            _event->window = decode_window(payload->configure.window);
+            subject = _event->window;
+            _event->above = decode_window(payload->configure.above);
+            _event->x = payload->configure.x;
+            _event->y = payload->configure.y;
+            _event->width = payload->configure.width;
+            _event->height = payload->configure.height;
+            _event->border_width = payload->configure.border_width;
+            _event->override_redirect = (flags & EVENT_TRACE_OVERRIDE_REDIRECT) != 0;
+            break;
+        }
+        case ConfigureRequest:
+        {
+            XConfigureRequestEvent *_event = &event->xconfigurerequest;
+            _event->parent = decode_window(payload->configure.event);
+            _event->window = decode_window(payload->configure.window);
+            subject = _event->window;
+            _event->above = decode_window(payload->configure.above);
+            _event->x = payload->configure.x;
+            _event->y = payload->configure.y;
+            _event->width = payload->configure.width;
+            _event->height = payload->configure.height;
+            _event->border_width = payload->configure.border_width;
+            _event->detail = payload->configure.detail;
+            _event->value_mask = payload->configure.value_mask;
+            break;
+        }
+        case Expose:
+            event->xexpose.window = decode_window(payload->expose.window);
+            subject = event->xexpose.window;
+            event->xexpose.x = payload->expose.x;
+            event->xexpose.y = payload->expose.y;
+            event->xexpose.width = payload->expose.width;
+            event->xexpose.height = payload->expose.height;
+            event->xexpose.count = payload->expose.count;
+            break;
+        case FocusIn:
+            event->xfocus.window = decode_window(payload->focus.window);
+            subject = event->xfocus.window;
+            event->xfocus.mode = payload->focus.mode;
+            event->xfocus.detail = payload->focus.detail;
+            break;
+        case PropertyNotify:
+            event->xproperty.window = decode_window(payload->property.window);
+            subject = event->xproperty.window;
+            event->xproperty.atom = decode_atom(payload->property.atom);
+            event->xproperty.state = payload->property.state;
+            break;
+        case ClientMessage:
+        {
+            XClientMessageEvent *_event = &event->xclient;
+            const EventTraceClientMessage *message = &payload->client_message;
+            _event->window = decode_window(message->window);
+            subject = _event->window;
+            _event->message_type = decode_atom(message->message_type);
+            _event->format = message->format;
+            if (message->format == 32)
+            {
+                for (int i = 0; i < 5; i++) _event->data.l[i] = (int32_t)message->data[i];
+                if (_event->message_type == ATOM(_NET_WM_STATE))
+                {
+                    _event->data.l[1] = decode_atom(message->data[1]);
+                    _event->data.l[2] = decode_atom(message->data[2]);
+                }
+            }
+            else
+            {
+                memcpy(_event->data.b, message->data, sizeof(message->data));
+            }
+            break;
+        }
+        case RawButtonPress:
+        case RawButtonRelease:
+            event->raw_button_press.button = payload->raw_input.detail;
+            return true;
+        case RawKeyPress:
+        case RawKeyRelease:
+            event->raw_key_press.key_code = payload->raw_input.detail;
+            return true;
+        case RawMotionNotify:
+            event->raw_motion_notify.delta_x = payload->raw_motion.delta_x;
+            event->raw_motion_notify.delta_y = payload->raw_motion.delta_y;
+            event->raw_motion_notify.device_id = payload->raw_motion.device_id;
+            return true;
+        default:
+            return true;
+    }
+    event->xany.send_event = (flags & EVENT_TRACE_SEND_EVENT) != 0;
+
+    // Skip the events about windows that have no stand-in.
+    return subject != None;
+}
+
+static size_t get_record_payload_size(int type)
+{
+    switch (type)
+    {
+        case EVENT_TRACE_WINDOW:
+        case CreateNotify:
+            return sizeof(EventTraceWindow);
+        case DestroyNotify:
+        case UnmapNotify:
+        case MapNotify:
+        case MapRequest:
+        case ReparentNotify:
+        case CirculateNotify:
+            return sizeof(EventTraceStructure);
+        case ConfigureNotify:
+        case ConfigureRequest:
+            return sizeof(EventTraceConfigure);
+        case Expose:
+            return sizeof(EventTraceExpose);
+        case FocusIn:
+            return sizeof(EventTraceFocus);
+        case PropertyNotify:
+            return sizeof(EventTraceProperty);
+        case ClientMessage:
+            return sizeof(EventTraceClientMessage);
+        case RawButtonPress:
+        case RawButtonRelease:
+        case RawKeyPress:
+        case RawKeyRelease:
+            return sizeof(EventTraceRawInput);
+        case RawMotionNotify:
+            return sizeof(EventTraceRawMotion);
+        case RawHierarchyChanged:
+        case Update:
+            return 0;
+        default:
+            return SIZE_MAX;
+    }
+}
+
+/**
+ * Reads the record at the offset into the loaded trace, returning its
+ * payload, or `NULL` once the end of the trace is reached.
+ */
+static const uint8_t *read_trace_record(size_t *offset, EventTraceRecord *out_record)
+{
+    if (replay_size - *offset < sizeof(EventTraceRecord)) return NULL;
+    memcpy(out_record, replay_data + *offset, sizeof(EventTraceRecord));
+    if (replay_size - *offset - sizeof(EventTraceRecord) < out_record->size) return NULL;
+    const uint8_t *payload = replay_data + *offset + sizeof(EventTraceRecord);
+    *offset += sizeof(EventTraceRecord) + out_record->size;
+    return payload;
+}
+
+static int load_event_trace()
+{
+    // Read the whole event trace file, so it can be validated up front and
+    // replaying it doesn't wait on disk reads.
+    FILE *file = fopen(replay_path, "rb");
+    if (file == NULL) return -1;
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        fclose(file);
+        return -1;
+    }
+    replay_size = (size_t)file_size;
+    replay_data = malloc(replay_size > 0 ? replay_size : 1);
+    if (replay_data == NULL || fread(replay_data, 1, replay_size, file) != replay_size)
+    {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    // Validate the header of the event trace.
+    EventTraceHeader header;
+    if (replay_size < sizeof(header)) return -2;
+    memcpy(&header, replay_data, sizeof(header));
+    if (memcmp(header.magic, EVENT_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != EVENT_TRACE_VERSION)
+    {
+        return -2;
+    }
+    Display *display = DefaultDisplay;
+    int screen = DefaultScreen(display);
+    if (header.screen_width != DisplayWidth(display, screen) ||
+        header.screen_height != DisplayHeight(display, screen))
+    {
+        LOG_WARNING(
+            "Event trace was recorded at %ux%u, replaying at %dx%d.",
+            header.screen_width, header.screen_height,
+            DisplayWidth(display, screen), DisplayHeight(display, screen)
+        );
+    }
+
+    // Validate the size of every record.
+    size_t offset = sizeof(header);
+    EventTraceRecord record;
+    while (read_trace_record(&offset, &record) != NULL)
+    {
+        // Atom records are followed by the atom name, of any length.
+        if (record.type == EVENT_TRACE_ATOM)
+        {
+            if (record.size <= sizeof(EventTraceAtom)) return -2;
+            continue;
+        }
+        if (record.size != get_record_payload_size(record.type)) return -2;
+    }
+    if (offset != replay_size) return -2;
+
+    return 0;
+}
+
+static int resolve_trace_atoms()
+{
+    // Collect the names of the recorded atoms.
+    unsigned int atom_count = 0;
+    size_t offset = sizeof(EventTraceHeader);
+    EventTraceRecord record;
+    while (read_trace_record(&offset, &record) != NULL)
+    {
+        if (record.type == EVENT_TRACE_ATOM) atom_count++;
+    }
+    if (atom_count == 0) return 0;
+    char **names = calloc(atom_count, sizeof(char *));
+    uint32_t *recorded = calloc(atom_count, sizeof(uint32_t));
+    Atom *atoms = calloc(atom_count, sizeof(Atom));
+    if (names == NULL || recorded == NULL || atoms == NULL)
+    {
+        free(names);
+        free(recorded);
+        free(atoms);
+        return -1;
+    }
+    unsigned int index = 0;
+    offset = sizeof(EventTraceHeader);
+    const uint8_t *payload;
+    while ((payload = read_trace_record(&offset, &record)) != NULL)
+    {
+        if (record.type != EVENT_TRACE_ATOM) continue;
+        size_t length = record.size - sizeof(EventTraceAtom);
+        EventTraceAtom atom;
+        memcpy(&atom, payload, sizeof(atom));
+        recorded[index] = atom.atom;
+        names[index] = strndup((const char *)payload + sizeof(EventTraceAtom), length);
+        if (names[index] == NULL) names[index] = strdup("");
+        index++;
+    }
+
+    // Intern all of them with a single round trip.
+    int status = 0;
+    if (X_ROUND_TRIP(XInternAtoms, DefaultDisplay, names, atom_count, False, atoms))
+    {
+        for (unsigned int i = 0; i < atom_count; i++)
+        {
+            TraceMapEntry *entry = insert_trace_map_entry(&replay_atoms, recorded[i]);
+            if (entry == NULL)
+            {
+                status = -1;
+                break;
+            }
+            entry->value = atoms[i];
+        }
+    }
+    else
+    {
+        status = -1;
+    }
+
+    for (unsigned int i = 0; i < atom_count; i++) free(names[i]);
+    free(names);
+    free(recorded);
+    free(atoms);
+    return status;
+}
+
+int prepare_event_replay()
+{
+    // Load and validate the event trace.
+    int status = load_event_trace();
+    if (status == -1)
+    {
+        LOG_ERROR("Failed to read event trace (%s).", replay_path);
+        return -1;
+    }
+    if (status == -2)
+    {
+        LOG_ERROR("Invalid or incompatible event trace (%s).", replay_path);
+        return -2;
+    }
+
+    // Map the recorded atoms to the atoms of the replaying display.
+    if (resolve_trace_atoms() != 0)
+    {
+        LOG_ERROR("Failed to resolve the atoms of the event trace (%s).", replay_path);
+        return -1;
+    }
+
+    // Create the stand-in windows of the windows that existed when recording
+    // started.
+    size_t offset = sizeof(EventTraceHeader);
+    EventTraceRecord record;
+    const uint8_t *payload;
+    while ((payload = read_trace_record(&offset, &record)) != NULL)
+    {
+        if (record.type != EVENT_TRACE_WINDOW) continue;
+        EventTraceWindow window;
+        memcpy(&window, payload, sizeof(window));
+        create_stand_in_window(&window);
+    }
+
+    return 0;
+}
+
+int replay_events()
+{
+    Display *display = DefaultDisplay;
+
+    // Dispatch each recorded event.
+    unsigned long event_count = 0, update_count = 0, skipped_count = 0;
+    uint64_t recorded_us = 0;
+    uint64_t start_us = get_monotonic_time_us();
+    size_t offset = sizeof(EventTraceHeader);
+    EventTraceRecord record;
+    const uint8_t *data;
+    while ((data = read_trace_record(&offset, &record)) != NULL)
+    {
+        recorded_us += record.delay_us;
+        if (record.type == EVENT_TRACE_ATOM || record.type == EVENT_TRACE_WINDOW) continue;
+
+        // Copy the payload, as records aren't aligned within the trace.
+        EventTracePayload payload;
+        memset(&payload, 0, sizeof(payload));
+        memcpy(&payload, data, record.size);
+
+        // Apply the recorded client change to its stand-in window, then
+        // dispatch the event.
+        mirror_client_change(record.type, &payload);
+        Event event;
+        if (!decode_event(record.type, &payload, &event))
+        {
+            skipped_count++;
+            continue;
+        }
+        call_event_handlers(&event);
+        event_count++;
+
+        // Flush the requests of each frame, discarding the events the
+        // replaying display sends, since the trace drives the handlers.
+        if (event.type == Update)
+        {
+            update_count++;
+            XEvent discarded;
+            while (XEventsQueued(display, QueuedAfterReading) > 0)
+            {
+                XNextEvent(display, &discarded);
+            }
+        }
+    }
+    X_ROUND_TRIP(XSync, display, False);
+    uint64_t replay_us = get_monotonic_time_us() - start_us;
+
+    free(replay_data);
+    replay_data = NULL;
+    free_trace_map(&replay_windows);
+    free_trace_map(&replay_atoms);
+
+    // Print the replay throughput.
+    fprintf(stderr,
+        "Replayed %lu events (%lu frames, %lu skipped) recorded over %.3f s "
+        "in %.3f s (%.0f events/s, %.0f frames/s).\n",
+        event_count, update_count, skipped_count,
+        recorded_us / 1000000.0, replay_us / 1000000.0,
+        replay_us > 0 ? event_count * 1000000.0 / replay_us : 0.0,
+        replay_us > 0 ? update_count * 1000000.0 / replay_us : 0.0
+    );
+
+    // Check the round trips made during the replay against the budget.
+    if (replay_budget_path[0] == '\0') return 0;
+    int budget_status = x_check_round_trip_budget(replay_budget_path);
+    if (budget_status == -1)
+    {
+        LOG_ERROR("Failed to open round trip budget (%s).", replay_budget_path);
+        return -3;
+    }
+    if (budget_status == -2) return -3;
+
+    return 0;
+}
+
+HANDLE(Initialize)
+{
+    // Never record while replaying.
+    if (is_event_replay_requested()) return;
+
+    // Get the event trace path from the configuration, recording is disabled
+    // when no path is set.
+    char cfg_trace_path[CONFIG_MAX_VALUE_LENGTH];
+    common.get_config_str(
+        cfg_trace_path, sizeof(cfg_trace_path),
+        CFG_KEY_EVENT_TRACE_PATH, CFG_DEFAULT_EVENT_TRACE_PATH
+    );
+    if (cfg_trace_path[0] == '\0') return;
+    char trace_path[COMMON_MAX_PATH_LENGTH];
+    if (common.expand_path(cfg_trace_path, trace_path, sizeof(trace_path)) != 0)
+    {
+        LOG_WARNING("Failed to expand event trace path (%s).", cfg_trace_path);
+        return;
+    }
+
+    // Open the event trace file.
+    trace_file = fopen(trace_path, "wb");
+    if (trace_file == NULL)
+    {
+        LOG_WARNING("Failed to open event trace (%s).", trace_path);
+        return;
+    }
+
+    // Write the header of the event trace.
+    Display *display = DefaultDisplay;
+    EventTraceHeader header = {
+        .version = EVENT_TRACE_VERSION,
+        .screen_width = (uint16_t)DisplayWidth(display, DefaultScreen(display)),
+        .screen_height = (uint16_t)DisplayHeight(display, DefaultScreen(display))
+    };
+    memcpy(header.magic, EVENT_TRACE_MAGIC, sizeof(header.magic));
+    if (fwrite(&header, sizeof(header), 1, trace_file) != 1)
+    {
+        LOG_WARNING("Failed to write event trace (%s).", trace_path);
+        close_event_trace();
+        return;
+    }
+    trace_last_us = get_monotonic_time_us();
+
+    // Record the windows that exist before any event, so the replay can
+    // recreate them.
+    record_existing_windows();
+
+    // Ensure buffered records are written when the window manager exits.
+    atexit(close_event_trace);
+}
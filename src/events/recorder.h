@@ -0,0 +1,204 @@
+#pragma once
+#include "../all.h"
+
+/** The magic bytes identifying an event trace file. */
+#define EVENT_TRACE_MAGIC "LWMTRACE"
+
+/** The version of the event trace format, bumped on incompatible changes. */
+#define EVENT_TRACE_VERSION 2
+
+/** The initial number of slots in the ID maps of the recorder. */
+#define EVENT_TRACE_MAP_INITIAL_CAPACITY 64
+
+/** The record type of an atom name, see `EventTraceAtom`. */
+#define EVENT_TRACE_ATOM 0
+
+/** The record type of a window existing when recording started. */
+#define EVENT_TRACE_WINDOW 1
+
+/** The window reference of the root window. */
+#define EVENT_TRACE_ROOT_WINDOW 0x40000000u
+
+/** Marks a window reference as the frame of the client window it holds. */
+#define EVENT_TRACE_FRAME_WINDOW 0x80000000u
+
+/** The flags of a recorded window or event. */
+#define EVENT_TRACE_OVERRIDE_REDIRECT (1 << 0)
+#define EVENT_TRACE_MAPPED (1 << 1)
+#define EVENT_TRACE_SEND_EVENT (1 << 2)
+#define EVENT_TRACE_FROM_CONFIGURE (1 << 3)
+
+/**
+ * The header at the start of an event trace file.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint16_t screen_width;
+    uint16_t screen_height;
+} EventTraceHeader;
+
+/**
+ * The header of a single record in an event trace file, followed by `size`
+ * bytes of payload, encoded according to the record type.
+ *
+ * Windows are stored as references: `0` for `None`, `EVENT_TRACE_ROOT_WINDOW`
+ * for the root window, the recorded window ID for client windows, or the
+ * client window ID marked with `EVENT_TRACE_FRAME_WINDOW` for frame windows.
+ * Atoms are stored as their recorded ID, which is preceded by an
+ * `EVENT_TRACE_ATOM` record naming it the first time it appears.
+ */
+typedef struct {
+    uint32_t delay_us;               // Time since the previous record.
+    uint16_t type;                   // Event type, or `EVENT_TRACE_*` type.
+    uint16_t size;                   // Size of the payload.
+} EventTraceRecord;
+
+/**
+ * The payload of an `EVENT_TRACE_ATOM` record, followed by the atom name
+ * (without a terminating null byte).
+ */
+typedef struct {
+    uint32_t atom;
+} EventTraceAtom;
+
+/** The payload of `EVENT_TRACE_WINDOW` and `CreateNotify` records. */
+typedef struct {
+    uint32_t window;
+    uint32_t parent;
+    int32_t x, y;
+    uint32_t width, height;
+    uint32_t border_width;
+    uint32_t flags;
+} EventTraceWindow;
+
+/**
+ * The payload of `DestroyNotify`, `UnmapNotify`, `MapNotify`, `MapRequest`,
+ * `ReparentNotify` and `CirculateNotify` records.
+ */
+typedef struct {
+    uint32_t event;                  // The parent for `MapRequest`.
+    uint32_t window;
+    uint32_t parent;
+    int32_t x, y;
+    int32_t detail;                  // The place for `CirculateNotify`.
+    uint32_t flags;
+} EventTraceStructure;
+
+/** The payload of `ConfigureNotify` and `ConfigureRequest` records. */
+typedef struct {
+    uint32_t event;                  // The parent for `ConfigureRequest`.
+    uint32_t window;
+    uint32_t above;
+    int32_t x, y;
+    uint32_t width, height;
+    uint32_t border_width;
+    int32_t detail;
+    uint32_t value_mask;
+    uint32_t flags;
+} EventTraceConfigure;
+
+/** The payload of `Expose` records. */
+typedef struct {
+    uint32_t window;
+    int32_t x, y;
+    uint32_t width, height;
+    int32_t count;
+} EventTraceExpose;
+
+/** The payload of `FocusIn` records. */
+typedef struct {
+    uint32_t window;
+    int32_t mode;
+    int32_t detail;
+} EventTraceFocus;
+
+/** The payload of `PropertyNotify` records. */
+typedef struct {
+    uint32_t window;
+    uint32_t atom;
+    int32_t state;
+} EventTraceProperty;
+
+/**
+ * The payload of `ClientMessage` records, the data items of 32-bit messages
+ * are stored one per element, other messages are stored byte by byte.
+ */
+typedef struct {
+    uint32_t window;
+    uint32_t message_type;
+    int32_t format;
+    uint32_t data[5];
+} EventTraceClientMessage;
+
+/** The payload of raw button and key records. */
+typedef struct {
+    int32_t detail;
+} EventTraceRawInput;
+
+/** The payload of `RawMotionNotify` records. */
+typedef struct {
+    double delta_x;
+    double delta_y;
+    int32_t device_id;
+} EventTraceRawMotion;
+
+/**
+ * Requests that the event loop replays an event trace instead of handling
+ * events from the X server.
+ *
+ * @param path The path of the event trace file.
+ * @param budget_path The path of a round trip budget file to check once the
+ * replay completes, or `NULL` to skip the check.
+ *
+ * @note - Must be called before `initialize_event_loop()`.
+ * @note - See `x_check_round_trip_budget()` for the budget file format.
+ */
+void request_event_replay(const char *path, const char *budget_path);
+
+/**
+ * Checks if the replay of an event trace was requested.
+ *
+ * @return - `true` - A replay was requested.
+ * @return - `false` - No replay was requested.
+ */
+bool is_event_replay_requested();
+
+/**
+ * Appends an event to the event trace, if recording is enabled.
+ *
+ * @param event The event that is about to be dispatched.
+ *
+ * @note - Recording is enabled by setting the event trace path in the
+ * configuration file.
+ * @note - Only the event types the window manager handles are recorded.
+ */
+void record_event(Event *event);
+
+/**
+ * Loads the requested event trace, and creates a stand-in window on the
+ * replaying display for each window that existed when recording started.
+ *
+ * @return - `0` - The event trace was loaded successfully.
+ * @return - `-1` - The event trace file could not be read.
+ * @return - `-2` - The event trace file is invalid or incompatible.
+ *
+ * @note - Must be called after the `Prepare` event, and before the `Initialize`
+ * event so the stand-in windows are adopted like the recorded ones were.
+ */
+int prepare_event_replay();
+
+/**
+ * Dispatches all events of the loaded event trace as fast as possible, and
+ * prints the replay throughput to `stderr`.
+ *
+ * @return - `0` - The event trace was replayed successfully.
+ * @return - `-3` - The round trip budget was exceeded, or could not be read.
+ *
+ * @note - Windows created by clients during recording get a stand-in window
+ * as well, which mirrors the recorded map state and geometry of unmanaged
+ * windows. Window and atom IDs are remapped to those of the replaying display,
+ * events about windows without a stand-in are skipped. Window properties are
+ * not recorded, so stand-in windows have none.
+ */
+int replay_events();
@@ -20,10 +20,25 @@ static RawButtonReleaseEvent construct_raw_button_release_event(XIRawEvent *raw_
 
 static RawMotionNotifyEvent construct_raw_motion_notify_event(XIRawEvent *raw_event)
 {
-    (void)raw_event;
     RawMotionNotifyEvent event = {
         .type = RawMotionNotify,
+        .device_id = raw_event->sourceid,
+        .delta_x = 0,
+        .delta_y = 0,
     };
+
+    // Extract the X and Y valuators, the values are packed in the order of the
+    // bits set in the valuator mask.
+    XIValuatorState *valuators = &raw_event->valuators;
+    int value_index = 0;
+    for (int axis = 0; axis < 2 && axis < valuators->mask_len * 8; axis++)
+    {
+        if (!XIMaskIsSet(valuators->mask, axis)) continue;
+        double value = valuators->values[value_index++];
+        if (axis == 0) event.delta_x = value;
+        if (axis == 1) event.delta_y = value;
+    }
+
     return event;
 }
 
@@ -45,6 +60,14 @@ static RawKeyReleaseEvent construct_raw_key_release_event(XIRawEvent *raw_event)
     return event;
 }
 
+static RawHierarchyChangedEvent construct_raw_hierarchy_changed_event()
+{
+    RawHierarchyChangedEvent event = {
+        .type = RawHierarchyChanged,
+    };
+    return event;
+}
+
 Event convert_raw_xinput_event(XIRawEvent *raw_event)
 {
     if (raw_event->evtype == XI_RawButtonPress)
@@ -67,6 +90,10 @@ Event convert_raw_xinput_event(XIRawEvent *raw_event)
     {
         return (Event)construct_raw_key_release_event(raw_event);
     }
+    else if (raw_event->evtype == XI_HierarchyChanged)
+    {
+        return (Event)construct_raw_hierarchy_changed_event();
+    }
     else
     {
         LOG_WARNING("Attempted to convert unsupported XInput2 event type (%d).", raw_event->evtype);
@@ -18,7 +18,7 @@ static void set_ewmh_active_window(Window client_window)
     current_active_window = client_window;
 
     // Set the `_NET_ACTIVE_WINDOW` property.
-    Atom _NET_ACTIVE_WINDOW = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
+    Atom _NET_ACTIVE_WINDOW = ATOM(_NET_ACTIVE_WINDOW);
     XChangeProperty(
         display,                            // Display
         DefaultRootWindow(display),         // Window
@@ -41,7 +41,7 @@ HANDLE(PortalFocused)
     PortalFocusedEvent *_event = &event->portal_focused;
     Portal *portal = _event->portal;
 
-    set_ewmh_active_window(portal->client_window);
+    set_ewmh_active_window(portal != NULL ? portal->client_window : None);
 }
 
 HANDLE(PortalDestroyed)
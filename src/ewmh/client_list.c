@@ -15,7 +15,9 @@ static void update_ewmh_client_list(Portal *exclude)
     Window root_window = DefaultRootWindow(display);
 
     // Allocate memory for the client list.
-    Window *client_list = malloc(MAX_PORTALS * sizeof(Window));
+    unsigned int portal_count = 0;
+    Portal **portals = get_active_portals(&portal_count);
+    Window *client_list = malloc((portal_count > 0 ? portal_count : 1) * sizeof(Window));
     if (client_list == NULL)
     {
         LOG_ERROR("Could not update EWMH client list, memory allocation failed.");
@@ -25,12 +27,10 @@ static void update_ewmh_client_list(Portal *exclude)
     // Build the client list from valid, initialized, top-level portals.
     // Per EWMH spec, _NET_CLIENT_LIST contains only top-level application
     // windows (for taskbars/switchers), excluding popups, tooltips, etc.
-    Portal *portals = get_unsorted_portals();
     int clients_added = 0;
-    for (int i = 0; i < MAX_PORTALS; i++)
+    for (unsigned int i = 0; i < portal_count; i++)
     {
-        Portal *portal = &portals[i];
-        if (!portal->active) continue;
+        Portal *portal = portals[i];
         if (portal == exclude) continue;
         if (!portal->initialized) continue;
         if (!portal->top_level) continue;
@@ -41,7 +41,7 @@ static void update_ewmh_client_list(Portal *exclude)
 
     // Update the `_NET_CLIENT_LIST` property on the root window.
     unsigned char *cast_client_list = (unsigned char *)client_list;
-    Atom _NET_CLIENT_LIST = XInternAtom(display, "_NET_CLIENT_LIST", False);
+    Atom _NET_CLIENT_LIST = ATOM(_NET_CLIENT_LIST);
     XChangeProperty(
         display,            // Display
         root_window,        // Window
@@ -58,6 +58,14 @@ static void update_ewmh_client_list(Portal *exclude)
 }
 
 HANDLE(PortalMapped)
+{
+    // Skip during batches, the list is updated once afterwards.
+    if (is_portal_batch_in_progress()) return;
+
+    update_ewmh_client_list(NULL);
+}
+
+HANDLE(PortalBatchEnded)
 {
     update_ewmh_client_list(NULL);
 }
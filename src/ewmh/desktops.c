@@ -9,6 +9,9 @@
  * - _NET_WM_DESKTOP: Per-window workspace assignment.
  * - _NET_DESKTOP_NAMES: Human-readable workspace names.
  *
+ * Additionally exposes `_LIMEOS_DESKTOP_THUMBNAILS`, the pixmaps holding the
+ * downscaled snapshot of each workspace, for pagers to copy from.
+ *
  * https://specifications.freedesktop.org/wm-spec/1.5/ar01s03.html#id-1.4.2
  */
 
@@ -20,7 +23,7 @@ static void set_number_of_desktops()
     Window root = DefaultRootWindow(display);
 
     // Set the `_NET_NUMBER_OF_DESKTOPS` property on the root window.
-    Atom _NET_NUMBER_OF_DESKTOPS = XInternAtom(display, "_NET_NUMBER_OF_DESKTOPS", False);
+    Atom _NET_NUMBER_OF_DESKTOPS = ATOM(_NET_NUMBER_OF_DESKTOPS);
     unsigned long count = MAX_WORKSPACES;
     XChangeProperty(
         display,
@@ -40,7 +43,7 @@ static void set_current_desktop(int workspace)
     Window root = DefaultRootWindow(display);
 
     // Set the `_NET_CURRENT_DESKTOP` property on the root window.
-    Atom _NET_CURRENT_DESKTOP = XInternAtom(display, "_NET_CURRENT_DESKTOP", False);
+    Atom _NET_CURRENT_DESKTOP = ATOM(_NET_CURRENT_DESKTOP);
     unsigned long desktop = workspace;
     XChangeProperty(
         display,
@@ -59,8 +62,8 @@ static void set_desktop_names()
     Display *display = DefaultDisplay;
     Window root = DefaultRootWindow(display);
 
-    Atom _NET_DESKTOP_NAMES = XInternAtom(display, "_NET_DESKTOP_NAMES", False);
-    Atom UTF8_STRING = XInternAtom(display, "UTF8_STRING", False);
+    Atom _NET_DESKTOP_NAMES = ATOM(_NET_DESKTOP_NAMES);
+    Atom UTF8_STRING = ATOM(UTF8_STRING);
 
     // Build null-separated string of workspace names.
     // Format: "1\02\03\04\05\06\0"
@@ -90,7 +93,7 @@ static void set_window_desktop(Window window, int workspace)
     Display *display = DefaultDisplay;
 
     // Set the `_NET_WM_DESKTOP` property on the specified window.
-    Atom _NET_WM_DESKTOP = XInternAtom(display, "_NET_WM_DESKTOP", False);
+    Atom _NET_WM_DESKTOP = ATOM(_NET_WM_DESKTOP);
     unsigned long desktop = workspace;
     XChangeProperty(
         display,
@@ -104,6 +107,32 @@ static void set_window_desktop(Window window, int workspace)
     );
 }
 
+static void set_desktop_thumbnails()
+{
+    Display *display = DefaultDisplay;
+    Window root = DefaultRootWindow(display);
+
+    // Collect the thumbnail pixmap of each workspace, `None` if missing.
+    unsigned long thumbnails[MAX_WORKSPACES];
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        thumbnails[i] = get_workspace_thumbnail(i);
+    }
+
+    // Set the `_LIMEOS_DESKTOP_THUMBNAILS` property on the root window.
+    Atom _LIMEOS_DESKTOP_THUMBNAILS = ATOM(_LIMEOS_DESKTOP_THUMBNAILS);
+    XChangeProperty(
+        display,
+        root,
+        _LIMEOS_DESKTOP_THUMBNAILS,
+        XA_PIXMAP,
+        32,
+        PropModeReplace,
+        (unsigned char *)thumbnails,
+        MAX_WORKSPACES
+    );
+}
+
 HANDLE(Initialize)
 {
     // Initialize all EWMH desktop properties on the root window.
@@ -120,6 +149,12 @@ HANDLE(WorkspaceSwitched)
     set_current_desktop(_event->new_workspace);
 }
 
+HANDLE(WorkspaceSnapshotted)
+{
+    // Update the `_LIMEOS_DESKTOP_THUMBNAILS` property with the new snapshot.
+    set_desktop_thumbnails();
+}
+
 HANDLE(PortalInitialized)
 {
     Portal *portal = event->portal_initialized.portal;
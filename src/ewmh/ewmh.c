@@ -15,9 +15,9 @@ static void setup_ewmh_identification_chain()
     Display *display = DefaultDisplay;
     Window root_window = DefaultRootWindow(display);
 
-    Atom _NET_SUPPORTING_WM_CHECK = XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False);
-    Atom _NET_WM_NAME = XInternAtom(display, "_NET_WM_NAME", False);
-    Atom UTF8_STRING = XInternAtom(display, "UTF8_STRING", False);
+    Atom _NET_SUPPORTING_WM_CHECK = ATOM(_NET_SUPPORTING_WM_CHECK);
+    Atom _NET_WM_NAME = ATOM(_NET_WM_NAME);
+    Atom UTF8_STRING = ATOM(UTF8_STRING);
 
     // Create a hidden check window.
     Window check_window = x_create_simple_window(display, root_window, -1, -1, 1, 1, 0, 0, 0);
@@ -71,26 +71,26 @@ static void setup_ewmh_supported_list()
 
     // Define a list of supported EWMH features.
     Atom features[] = {
-        XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False),
-        XInternAtom(display, "_NET_WM_NAME", False),
-        XInternAtom(display, "_NET_CLIENT_LIST", False),
-        XInternAtom(display, "_NET_WM_ACTION_MOVE", False),
-        XInternAtom(display, "_NET_WM_ACTION_RESIZE", False),
-        XInternAtom(display, "_NET_WM_MOVERESIZE", False),
-        XInternAtom(display, "_NET_MOVERESIZE_WINDOW", False),
-        XInternAtom(display, "_NET_WM_WINDOW_TYPE", False),
-        XInternAtom(display, "_NET_WM_STATE", False),
-        XInternAtom(display, "_NET_WM_STATE_FULLSCREEN", False),
-        XInternAtom(display, "_NET_NUMBER_OF_DESKTOPS", False),
-        XInternAtom(display, "_NET_CURRENT_DESKTOP", False),
-        XInternAtom(display, "_NET_WM_DESKTOP", False),
-        XInternAtom(display, "_NET_DESKTOP_NAMES", False),
-        XInternAtom(display, "_NET_CLOSE_WINDOW", False)
+        ATOM(_NET_SUPPORTING_WM_CHECK),
+        ATOM(_NET_WM_NAME),
+        ATOM(_NET_CLIENT_LIST),
+        ATOM(_NET_WM_ACTION_MOVE),
+        ATOM(_NET_WM_ACTION_RESIZE),
+        ATOM(_NET_WM_MOVERESIZE),
+        ATOM(_NET_MOVERESIZE_WINDOW),
+        ATOM(_NET_WM_WINDOW_TYPE),
+        ATOM(_NET_WM_STATE),
+        ATOM(_NET_WM_STATE_FULLSCREEN),
+        ATOM(_NET_NUMBER_OF_DESKTOPS),
+        ATOM(_NET_CURRENT_DESKTOP),
+        ATOM(_NET_WM_DESKTOP),
+        ATOM(_NET_DESKTOP_NAMES),
+        ATOM(_NET_CLOSE_WINDOW)
     };
 
     // Set the `_NET_SUPPORTED` property on the root window, listing all the
     // EWMH features that our window manager supports.
-    Atom _NET_SUPPORTED = XInternAtom(display, "_NET_SUPPORTED", False);
+    Atom _NET_SUPPORTED = ATOM(_NET_SUPPORTED);
     XChangeProperty(
         display,                            // Display
         root_window,                        // Window
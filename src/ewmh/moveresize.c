@@ -18,23 +18,12 @@
 #define _NET_WM_MOVERESIZE_MOVE_KEYBOARD     10
 #define _NET_WM_MOVERESIZE_CANCEL            11
 
-static Atom _NET_WM_MOVERESIZE = None;
-static Atom _NET_CLOSE_WINDOW = None;
-
-HANDLE(Prepare)
-{
-    Display *display = DefaultDisplay;
-
-    _NET_WM_MOVERESIZE = XInternAtom(display, "_NET_WM_MOVERESIZE", False);
-    _NET_CLOSE_WINDOW = XInternAtom(display, "_NET_CLOSE_WINDOW", False);
-}
-
 HANDLE(ClientMessage)
 {
     XClientMessageEvent *xclient = &event->xclient;
 
     // Ensure this is a `_NET_WM_MOVERESIZE` message / request.
-    if (xclient->message_type != _NET_WM_MOVERESIZE) return;
+    if (xclient->message_type != ATOM(_NET_WM_MOVERESIZE)) return;
 
     // Find the portal associated with the request.
     Portal *portal = find_portal_by_window(xclient->window);
@@ -76,7 +65,7 @@ HANDLE(ClientMessage)
     XClientMessageEvent *xclient = &event->xclient;
 
     // Ensure this is a `_NET_CLOSE_WINDOW` message / request.
-    if (xclient->message_type != _NET_CLOSE_WINDOW) return;
+    if (xclient->message_type != ATOM(_NET_CLOSE_WINDOW)) return;
 
     // Find the portal associated with the request.
     Portal *portal = find_portal_by_window(xclient->window);
@@ -2,6 +2,8 @@
 
 static const char *libraries[] = {
     "libX11.so.6",
+    "libX11-xcb.so.1",
+    "libxcb.so.1",
     "libXi.so.6",
     "libXfixes.so.3",
     "libXrandr.so.2",
@@ -11,6 +13,9 @@ static const char *libraries[] = {
 
 static int custom_x_error_handler(Display *display, XErrorEvent *error)
 {
+    // Pass errors of tracked request ranges to their callbacks.
+    if (x_handle_tracked_error(display, error)) return 0;
+
     // Ignore BadWindow errors.
     if (error->error_code == BadWindow) return 0;
 
@@ -27,8 +32,34 @@ static int custom_x_error_handler(Display *display, XErrorEvent *error)
     return 0;
 }
 
-int main()
+static int custom_x_io_error_handler(Display *display)
+{
+    (void)display;
+
+    // Remember the connection is lost, so exit handlers don't use it.
+    x_mark_connection_lost();
+    LOG_ERROR("Lost the connection to the X11 display.");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
 {
+    // Check the computed tiling layouts against the fixed layout table they
+    // replaced, then exit (--check-tiling).
+    if (argc >= 2 && strcmp(argv[1], "--check-tiling") == 0)
+    {
+        return (check_tiling_layouts() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Check if an event trace should be replayed, optionally checking the
+    // round trips against a budget (--replay <path> [--budget <path>]).
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+    {
+        const char *budget_path = NULL;
+        if (argc >= 5 && strcmp(argv[3], "--budget") == 0) budget_path = argv[4];
+        request_event_replay(argv[2], budget_path);
+    }
+
     // Ensure the program isn't being run as root.
     if (geteuid() == 0)
     {
@@ -71,8 +102,9 @@ int main()
     // Set input focus on the root window.
     x_focus_window(display, DefaultRootWindow(display));
 
-    // Set a custom X11 error handler.
+    // Set custom X11 error handlers.
     XSetErrorHandler(custom_x_error_handler);
+    XSetIOErrorHandler(custom_x_io_error_handler);
 
     // Initialize the event loop.
     initialize_event_loop();
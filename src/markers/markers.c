@@ -45,7 +45,7 @@ static void show_marker(Marker *marker)
     Cursor cursor = marker->cursor;
     if (marker->grab == true)
     {
-        XGrabPointer(
+        X_ROUND_TRIP(XGrabPointer,
             display,        // Display
             root_window,    // Window
             True,           // OwnerEvents
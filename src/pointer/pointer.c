@@ -0,0 +1,170 @@
+/**
+ * This code is responsible for tracking the pointer position on behalf of the
+ * rest of the window manager. Raw XInput2 events carry no position, so the
+ * position is accumulated from the raw valuators of relative devices, and
+ * resynchronized with the X server occasionally to correct any drift (warps,
+ * pointer barriers, screen edges), and before every click. Absolute devices
+ * are resynchronized on every motion, since their valuators are not expressed
+ * in screen pixels.
+ */
+
+#include "../all.h"
+
+/** The maximum number of input devices whose valuator mode is cached. */
+#define MAX_POINTER_DEVICES 256
+
+typedef enum {
+    POINTER_DEVICE_UNKNOWN = 0,
+    POINTER_DEVICE_RELATIVE,
+    POINTER_DEVICE_ABSOLUTE
+} PointerDeviceMode;
+
+static PointerDeviceMode device_modes[MAX_POINTER_DEVICES] = {0};
+
+static double pointer_x_root = 0, pointer_y_root = 0;
+static bool moved_since_sync = false;
+static Time last_sync_time = 0;
+
+static PointerDeviceMode get_device_mode(int device_id)
+{
+    // Treat devices outside of the cache as absolute, forcing a resync.
+    if (device_id < 0 || device_id >= MAX_POINTER_DEVICES)
+    {
+        return POINTER_DEVICE_ABSOLUTE;
+    }
+
+    // Return the cached mode, if the device was queried before.
+    if (device_modes[device_id] != POINTER_DEVICE_UNKNOWN)
+    {
+        return device_modes[device_id];
+    }
+
+    // Query the device, this happens once per device.
+    int device_count = 0;
+    XIDeviceInfo *devices = X_ROUND_TRIP(XIQueryDevice, DefaultDisplay, device_id, &device_count);
+    PointerDeviceMode mode = POINTER_DEVICE_ABSOLUTE;
+    for (int i = 0; i < device_count; i++)
+    {
+        for (int j = 0; j < devices[i].num_classes; j++)
+        {
+            // Only consider the valuator of the X axis.
+            XIAnyClassInfo *class = devices[i].classes[j];
+            if (class->type != XIValuatorClass) continue;
+            XIValuatorClassInfo *valuator = (XIValuatorClassInfo*)class;
+            if (valuator->number != 0) continue;
+
+            mode = (valuator->mode == XIModeAbsolute)
+                ? POINTER_DEVICE_ABSOLUTE
+                : POINTER_DEVICE_RELATIVE;
+        }
+    }
+    if (devices != NULL) XIFreeDeviceInfo(devices);
+
+    // Cache the mode of the device.
+    device_modes[device_id] = mode;
+    return mode;
+}
+
+static void notify_pointer_moved()
+{
+    // Call all event handlers of the PointerMoved event.
+    int x_root, y_root;
+    get_pointer_position(&x_root, &y_root);
+    call_event_handlers((Event*)&(PointerMovedEvent){
+        .type = PointerMoved,
+        .x_root = x_root,
+        .y_root = y_root
+    });
+}
+
+void get_pointer_position(int *out_x_root, int *out_y_root)
+{
+    if (out_x_root != NULL) *out_x_root = (int)pointer_x_root;
+    if (out_y_root != NULL) *out_y_root = (int)pointer_y_root;
+}
+
+Portal *get_portal_under_pointer()
+{
+    int x_root, y_root;
+    get_pointer_position(&x_root, &y_root);
+    return find_portal_at_pos(x_root, y_root);
+}
+
+void synchronize_pointer()
+{
+    Display *display = DefaultDisplay;
+    Window root_window = DefaultRootWindow(display);
+
+    // Query the actual pointer position.
+    int x_root = 0, y_root = 0;
+    X_ROUND_TRIP(XQueryPointer,
+        display,            // Display
+        root_window,        // Window
+        &(Window){0},       // Root (Unused)
+        &(Window){0},       // Child (Unused)
+        &x_root,            // Pointer X (Relative to root)
+        &y_root,            // Pointer Y (Relative to root)
+        &(int){0},          // Window X (Unused)
+        &(int){0},          // Window Y (Unused)
+        &(unsigned int){0}  // Mask (Unused)
+    );
+    moved_since_sync = false;
+    last_sync_time = x_get_current_time();
+
+    // Ensure the tracked position was out of date.
+    if (x_root == (int)pointer_x_root && y_root == (int)pointer_y_root) return;
+
+    // Store the actual pointer position.
+    pointer_x_root = x_root;
+    pointer_y_root = y_root;
+    notify_pointer_moved();
+}
+
+HANDLE(Initialize)
+{
+    synchronize_pointer();
+}
+
+HANDLE(RawMotionNotify)
+{
+    RawMotionNotifyEvent *_event = &event->raw_motion_notify;
+    Display *display = DefaultDisplay;
+    int screen = DefaultScreen(display);
+
+    // Resynchronize immediately for absolute devices.
+    if (get_device_mode(_event->device_id) == POINTER_DEVICE_ABSOLUTE)
+    {
+        synchronize_pointer();
+        return;
+    }
+
+    // Ensure the pointer actually moved.
+    if (_event->delta_x == 0 && _event->delta_y == 0) return;
+
+    // Accumulate the deltas, keeping the pointer within the screen bounds.
+    double max_x = DisplayWidth(display, screen) - 1;
+    double max_y = DisplayHeight(display, screen) - 1;
+    pointer_x_root += _event->delta_x;
+    pointer_y_root += _event->delta_y;
+    if (pointer_x_root < 0) pointer_x_root = 0;
+    if (pointer_y_root < 0) pointer_y_root = 0;
+    if (pointer_x_root > max_x) pointer_x_root = max_x;
+    if (pointer_y_root > max_y) pointer_y_root = max_y;
+    moved_since_sync = true;
+
+    notify_pointer_moved();
+}
+
+HANDLE(RawHierarchyChanged)
+{
+    // Forget the cached device modes, as device IDs may have been reused.
+    memset(device_modes, 0, sizeof(device_modes));
+}
+
+HANDLE(Update)
+{
+    // Periodically correct any drift while the pointer is moving.
+    if (!moved_since_sync) return;
+    if (x_get_current_time() - last_sync_time < POINTER_RESYNC_INTERVAL_MS) return;
+    synchronize_pointer();
+}
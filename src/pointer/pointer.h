@@ -0,0 +1,37 @@
+#pragma once
+#include "../all.h"
+
+/** The interval at which a moving pointer is resynchronized with the server. */
+#define POINTER_RESYNC_INTERVAL_MS 1000
+
+/**
+ * Retrieves the tracked position of the pointer.
+ *
+ * @param out_x_root The buffer where the X coordinate (relative to root) will
+ * be stored.
+ * @param out_y_root The buffer where the Y coordinate (relative to root) will
+ * be stored.
+ *
+ * @note - The position is maintained from raw XInput2 motion, so retrieving it
+ * does not require a round trip to the X server.
+ */
+void get_pointer_position(int *out_x_root, int *out_y_root);
+
+/**
+ * Retrieves the topmost visible portal under the tracked pointer position.
+ *
+ * @return - `Portal*` - The portal under the pointer.
+ * @return - `NULL` - No portal is located under the pointer.
+ *
+ * @note - The portal is resolved from the window manager's own stacking order
+ * and geometry data, without querying the X server.
+ */
+Portal *get_portal_under_pointer();
+
+/**
+ * Resynchronizes the tracked pointer position with the X server.
+ *
+ * @note - This function performs a round trip to the X server, and triggers a
+ * `PointerMoved` event if the tracked position was out of date.
+ */
+void synchronize_pointer();
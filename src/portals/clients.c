@@ -5,7 +5,7 @@ bool is_portal_client_valid(Portal *portal)
     return (
         portal != NULL &&
         portal->client_window != 0 &&
-        x_window_exists(DefaultDisplay, portal->client_window)
+        portal->client_alive
     );
 }
 
@@ -16,8 +16,8 @@ int destroy_portal_client(Portal *portal)
 
     // Try to gracefully close via the `WM_DELETE_WINDOW` protocol (Newer),
     // fallback to `XDestroyWindow()` if protocol is unsupported (Older).
-    Atom WM_PROTOCOLS = XInternAtom(display, "WM_PROTOCOLS", False);
-    Atom WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    Atom WM_PROTOCOLS = ATOM(WM_PROTOCOLS);
+    Atom WM_DELETE_WINDOW = ATOM(WM_DELETE_WINDOW);
     if(x_window_supports_protocol(display, client_window, WM_DELETE_WINDOW))
     {
         int status = XSendEvent(display, client_window, False, NoEventMask, (XEvent*)&(XClientMessageEvent) {
@@ -34,7 +34,9 @@ int destroy_portal_client(Portal *portal)
     {
         int status = XDestroyWindow(display, client_window);
         if (status == 0) return -2;
+        unindex_portal_window(client_window);
         portal->client_window = 0;
+        portal->client_alive = false;
     }
 
     return 0;
@@ -49,16 +51,16 @@ HANDLE(CreateNotify)
     // Ensure the window isn't an off-screen dummy window.
     if (_event->x < 0 || _event->y < 0) return;
 
+    // Only create portals for top-level windows (direct children of root).
+    // Per ICCCM Section 4.1.1, top-level windows are direct children of root.
+    // Child windows of applications should not become portals. Checked before
+    // the PID, which costs a round trip.
+    if (_event->parent != root_window) return;
+
     // Ensure the window wasn't created by ourselves.
     pid_t pid = x_get_window_pid(display, _event->window);
     if (pid == getpid()) return;
 
-    // Only create portals for top-level windows (direct children of root).
-    // Per ICCCM Section 4.1.1, top-level windows are direct children of root.
-    // Child windows of applications should not become portals.
-    Window parent_window = x_get_window_parent(display, _event->window);
-    if (parent_window != root_window) return;
-
     // Create a portal for the window.
     create_portal(_event->window);
 }
@@ -67,11 +69,53 @@ HANDLE(DestroyNotify)
 {
     XDestroyWindowEvent *_event = &event->xdestroywindow;
 
+    // Ensure the event came from a portal window.
+    Portal *portal = find_portal_by_window(_event->window);
+    if (portal == NULL) return;
+
+    // Release a destroyed frame window, the portal itself lives on until its
+    // client window is destroyed.
+    if (portal->frame_window == _event->window)
+    {
+        unindex_portal_window(portal->frame_window);
+        portal->frame_window = None;
+        portal->frame_alive = false;
+        return;
+    }
+
+    // Mark the client window as destroyed, then destroy the portal.
+    portal->client_alive = false;
+    destroy_portal(portal);
+}
+
+HANDLE(ReparentNotify)
+{
+    XReparentEvent *_event = &event->xreparent;
+
     // Ensure the event came from a portal client window.
     Portal *portal = find_portal_by_window(_event->window);
     if (portal == NULL || portal->client_window != _event->window) return;
 
-    // Destroy the portal.
+    // Keep track of the client parent, so the client can be positioned
+    // without querying the window tree.
+    portal->client_parent = _event->parent;
+
+    // Release a client reparented away from its frame by another client
+    // (e.g., swallowed or embedded), as it is no longer ours to manage.
+    Window root_window = DefaultRootWindow(DefaultDisplay);
+    if (_event->parent == root_window || _event->parent == portal->frame_window)
+    {
+        // Apply a move that was kept pending while the parent was unknown.
+        if (portal->transform_pending)
+        {
+            begin_portal_transaction();
+            commit_portal_transaction();
+        }
+        return;
+    }
+    XRemoveFromSaveSet(DefaultDisplay, portal->client_window);
+    unindex_portal_window(portal->client_window);
+    portal->client_alive = false;
     destroy_portal(portal);
 }
 
@@ -85,6 +129,10 @@ HANDLE(MapRequest)
     Portal *portal = find_or_create_portal(_event->window);
     if (portal == NULL || portal->client_window != _event->window) return;
 
+    // Fetch the client window properties in a single batch, before they are
+    // needed by the limit check below and by the mapping itself.
+    populate_portal_properties(portal);
+
     // Populate the portal's `transient_for` value for the limit check below.
     populate_portal_transient_for(portal);
 
@@ -92,7 +140,7 @@ HANDLE(MapRequest)
     if (portal->transient_for == NULL)
     {
         int workspace = determine_portal_workspace(portal);
-        if (count_workspace_portals(workspace) >= MAX_WORKSPACE_PORTALS)
+        if (count_workspace_portals(workspace) >= get_workspace_capacity())
         {
             // Set WM_STATE to WithdrawnState so the client knows
             // its map was not accepted (ICCCM 4.1.4).
@@ -100,7 +148,7 @@ HANDLE(MapRequest)
 
             LOG_WARNING(
                 "Workspace %d is full (%d portals); map denied.",
-                workspace, MAX_WORKSPACE_PORTALS
+                workspace, get_workspace_capacity()
             );
             return;
         }
@@ -196,9 +244,9 @@ HANDLE(ConfigureRequest)
     else
     {
         // For non-framed windows, apply configuration changes as requested.
-        // Trap errors because the request can reference a sibling window
+        // Ignore errors because the request can reference a sibling window
         // that no longer exists (e.g., rapidly destroyed popup).
-        x_trap_errors(display);
+        unsigned long first_request = x_begin_error_range(display, NULL, NULL);
         XConfigureWindow(
             display,
             client_window,
@@ -213,7 +261,7 @@ HANDLE(ConfigureRequest)
                 .stack_mode = _event->detail
             }
         );
-        x_untrap_errors(display);
+        x_end_error_range(display, first_request);
     }
 }
 
@@ -226,22 +274,46 @@ HANDLE(ConfigureNotify)
     Portal *portal = find_portal_by_window(_event->window);
     if (portal == NULL || _event->window != portal->client_window) return;
 
+    // Ignore synthetic events, they don't reflect the actual window geometry.
+    if (_event->send_event) return;
+
     // Skip geometry enforcement and synchronization for fullscreen portals.
     // Fullscreen portals have their geometry managed by fullscreen.c.
     if (portal->fullscreen) return;
 
-    // Enforce client position within the frame for framed portals.
-    // Some clients try to move themselves even after being reparented.
+    // Ignore events generated before the latest configure request of the WM,
+    // as the stored geometry already supersedes them (e.g., during drags).
+    if (_event->serial < portal->cold->configure_serial) return;
+
+    // Calculate the client geometry relative to root from the event.
+    PortalGeometry client_geometry = {
+        .x_root = _event->x,
+        .y_root = _event->y,
+        .width = _event->width,
+        .height = _event->height
+    };
     if (is_portal_frame_valid(portal))
     {
+        // Enforce client position within the frame for framed portals.
+        // Some clients try to move themselves even after being reparented.
         // Move back only if the position is incorrect.
         if (_event->x != 0 || _event->y != PORTAL_TITLE_BAR_HEIGHT)
         {
             portal->misaligned = true;
             XMoveWindow(display, portal->client_window, 0, PORTAL_TITLE_BAR_HEIGHT);
         }
+
+        // The client is positioned below the title bar by the WM.
+        client_geometry.x_root = portal->geometry.x_root;
+        client_geometry.y_root = portal->geometry.y_root + PORTAL_TITLE_BAR_HEIGHT;
+    }
+    else if (portal->client_parent != DefaultRootWindow(display))
+    {
+        // The position is relative to a foreign parent, keep the stored one.
+        client_geometry.x_root = portal->geometry.x_root;
+        client_geometry.y_root = portal->geometry.y_root;
     }
 
     // Synchronize the portal geometry.
-    synchronize_portal(portal);
+    synchronize_portal(portal, client_geometry);
 }
@@ -8,6 +8,11 @@
  * 
  * @return - `True (1)` The portal client is valid.
  * @return - `False (0)` The portal client is invalid.
+ *
+ * @note Based on the client lifecycle as tracked through `DestroyNotify`
+ * events, so this never queries the X server. Requests racing a destruction
+ * that has not been processed yet must tolerate (or ignore) the resulting
+ * errors.
  */
 bool is_portal_client_valid(Portal *portal);
 
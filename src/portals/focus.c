@@ -35,6 +35,29 @@ HANDLE(PortalFocused)
     focused_portal = event->portal_focused.portal;
 }
 
+HANDLE(FocusIn)
+{
+    XFocusChangeEvent *_event = &event->xfocus;
+
+    // Ignore focus changes caused by grabs, or following the pointer.
+    if (_event->mode == NotifyGrab || _event->mode == NotifyUngrab) return;
+    if (_event->detail == NotifyPointer) return;
+
+    // Ensure focus moved to a managed portal client window.
+    Portal *portal = find_portal_by_window(_event->window);
+    if (portal == NULL || portal->client_window != _event->window) return;
+    if (portal->override_redirect) return;
+    if (portal->visibility != PORTAL_VISIBLE) return;
+
+    // Track focus that a client moved itself, e.g. between its own
+    // top-level windows, without raising the portal.
+    if (portal == focused_portal) return;
+    call_event_handlers((Event*)&(PortalFocusedEvent){
+        .type = PortalFocused,
+        .portal = portal
+    });
+}
+
 HANDLE(PortalDestroyed)
 {
     PortalDestroyedEvent *_event = &event->portal_destroyed;
@@ -96,6 +119,9 @@ HANDLE(PortalMapped)
     // These manage their own focus and stealing it breaks app behavior.
     if (portal->override_redirect) return;
 
+    // Skip during batches, which settle focus once afterwards.
+    if (is_portal_batch_in_progress()) return;
+
     // Set keyboard focus to the newly mapped portal.
     x_focus_window(DefaultDisplay, portal->client_window);
 
@@ -105,3 +131,26 @@ HANDLE(PortalMapped)
         .portal = portal
     });
 }
+
+HANDLE(PortalsAdopted)
+{
+    // Find the topmost adopted portal on the current workspace.
+    unsigned int count = 0;
+    Portal **sorted = get_sorted_portals(&count);
+    for (int i = (int)count - 1; i >= 0; i--)
+    {
+        Portal *portal = sorted[i];
+        if (portal == NULL) continue;
+        if (portal->override_redirect) continue;
+        if (!portal->initialized || portal->visibility != PORTAL_VISIBLE) continue;
+        if (portal->workspace != get_current_workspace()) continue;
+
+        // Set keyboard focus to it and notify.
+        x_focus_window(DefaultDisplay, portal->client_window);
+        call_event_handlers((Event*)&(PortalFocusedEvent){
+            .type = PortalFocused,
+            .portal = portal
+        });
+        break;
+    }
+}
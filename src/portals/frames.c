@@ -8,7 +8,6 @@
 bool should_portal_be_framed(Portal *portal)
 {
     Display *display = DefaultDisplay;
-    Window client_window = portal->client_window;
 
     // Check if portal is a managed top-level window (ICCCM).
     if (!portal->top_level)
@@ -17,7 +16,7 @@ bool should_portal_be_framed(Portal *portal)
     }
 
     // Check Motif hints for decoration preferences.
-    if (!x_window_wants_decorations_motif(display, client_window))
+    if (!portal->cold->properties.wants_decorations)
     {
         return false;
     }
@@ -68,8 +67,12 @@ void create_portal_frame(Portal *portal)
 
     // Assign the frame window and Cairo context to the portal.
     portal->frame_window = frame_window;
-    portal->frame_cr = cr;
-    portal->frame_visual = visual;
+    portal->frame_alive = true;
+    portal->cold->frame_cr = cr;
+    portal->cold->frame_visual = visual;
+
+    // Index the frame window, so the portal can be found by it.
+    index_portal_window(portal, frame_window, PORTAL_WINDOW_FRAME);
 
     // Add the client window to our save-set so it survives if the WM exits.
     XAddToSaveSet(display, portal->client_window);
@@ -82,11 +85,16 @@ void create_portal_frame(Portal *portal)
         0,                      // X (Relative to parent)
         PORTAL_TITLE_BAR_HEIGHT // Y (Relative to parent)
     );
+    portal->client_parent = portal->frame_window;
+
+    // Mirror the new frame on top of the stacking order, in place of the
+    // client window.
+    raise_stacked_window(frame_window);
 
     // Set _NET_FRAME_EXTENTS to inform the client about decoration sizes.
     // This is needed for applications to correctly calculate coordinates
     // (e.g., for drag and drop operations).
-    Atom _NET_FRAME_EXTENTS = XInternAtom(display, "_NET_FRAME_EXTENTS", False);
+    Atom _NET_FRAME_EXTENTS = ATOM(_NET_FRAME_EXTENTS);
     unsigned long extents[4] = {
         0,                        // Left
         0,                        // Right
@@ -108,7 +116,7 @@ void create_portal_frame(Portal *portal)
 void draw_portal_frame(Portal *portal)
 {
     const Theme *theme = get_portal_theme(portal);
-    cairo_t *cr = portal->frame_cr;
+    cairo_t *cr = portal->cold->frame_cr;
     unsigned int width = portal->geometry.width;
     unsigned int height = portal->geometry.height;
 
@@ -164,22 +172,24 @@ bool is_portal_frame_valid(Portal *portal)
     return (
         portal != NULL &&
         portal->frame_window != 0 &&
-        x_window_exists(DefaultDisplay, portal->frame_window)
+        portal->frame_alive
     );
 }
 
 int destroy_portal_frame(Portal *portal)
 {
     // Destroy the Cairo context and surface.
-    cairo_surface_t *surface = cairo_get_target(portal->frame_cr);
-    cairo_destroy(portal->frame_cr);
+    cairo_surface_t *surface = cairo_get_target(portal->cold->frame_cr);
+    cairo_destroy(portal->cold->frame_cr);
     cairo_surface_destroy(surface);
-    portal->frame_cr = NULL;
+    portal->cold->frame_cr = NULL;
 
     // Destroy the frame window.
     int status = XDestroyWindow(DefaultDisplay, portal->frame_window);
     if (status == 0) return -1;
+    unindex_portal_window(portal->frame_window);
     portal->frame_window = 0;
+    portal->frame_alive = false;
 
     return 0;
 }
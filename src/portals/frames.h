@@ -45,6 +45,10 @@ void draw_portal_frame(Portal *portal);
  * 
  * @return - `True (1)` The portal frame is valid.
  * @return - `False (0)` The portal frame is invalid.
+ *
+ * @note Based on the frame lifecycle as tracked by the window manager, so
+ * this never queries the X server. Requests racing a destruction that has
+ * not been processed yet must tolerate (or ignore) the resulting errors.
  */
 bool is_portal_frame_valid(Portal *portal);
 
@@ -5,10 +5,6 @@
 
 #include "../all.h"
 
-static Atom _NET_WM_STATE = None;
-static Atom _NET_WM_STATE_FULLSCREEN = None;
-static Atom _NET_FRAME_EXTENTS = None;
-
 static void set_fullscreen_state(Portal *portal, bool fullscreen)
 {
     Display *display = DefaultDisplay;
@@ -21,8 +17,8 @@ static void set_fullscreen_state(Portal *portal, bool fullscreen)
     unsigned char *data = NULL;
     Atom *states = NULL;
     unsigned long state_count = 0;
-    if (XGetWindowProperty(
-        display, window, _NET_WM_STATE, 0, 1024, False,
+    if (X_ROUND_TRIP(XGetWindowProperty,
+        display, window, ATOM(_NET_WM_STATE), 0, 1024, False,
         XA_ATOM, &actual_type, &actual_format, &nitems,
         &bytes_after, &data) == Success && data != NULL
     ) {
@@ -35,7 +31,7 @@ static void set_fullscreen_state(Portal *portal, bool fullscreen)
     unsigned long existing_index = 0;
     for (unsigned long i = 0; i < state_count; i++)
     {
-        if (states[i] == _NET_WM_STATE_FULLSCREEN)
+        if (states[i] == ATOM(_NET_WM_STATE_FULLSCREEN))
         {
             already_set = true;
             existing_index = i;
@@ -60,11 +56,11 @@ static void set_fullscreen_state(Portal *portal, bool fullscreen)
         {
             new_states[i] = states[i];
         }
-        new_states[state_count] = _NET_WM_STATE_FULLSCREEN;
+        new_states[state_count] = ATOM(_NET_WM_STATE_FULLSCREEN);
 
         // Update the property.
         XChangeProperty(
-            display, window, _NET_WM_STATE, XA_ATOM, 32,
+            display, window, ATOM(_NET_WM_STATE), XA_ATOM, 32,
             PropModeReplace, (unsigned char *)new_states,
             state_count + 1
         );
@@ -93,7 +89,7 @@ static void set_fullscreen_state(Portal *portal, bool fullscreen)
 
         // Update the property.
         XChangeProperty(
-            display, window, _NET_WM_STATE, XA_ATOM, 32,
+            display, window, ATOM(_NET_WM_STATE), XA_ATOM, 32,
             PropModeReplace, (unsigned char *)new_states,
             new_count
         );
@@ -118,7 +114,7 @@ void enter_portal_fullscreen(Portal *portal)
     XGrabServer(display);
 
     // Back up current portal geometry for restore.
-    portal->geometry_fullscreen_backup = portal->geometry;
+    portal->cold->geometry_fullscreen_backup = portal->geometry;
 
     // Redirect the client window for direct compositing.
     // When reparented to a frame, the client is no longer a direct child of 
@@ -160,7 +156,7 @@ void enter_portal_fullscreen(Portal *portal)
     {
         unsigned long extents[4] = {0, 0, 0, 0};
         XChangeProperty(
-            display, portal->client_window, _NET_FRAME_EXTENTS,
+            display, portal->client_window, ATOM(_NET_FRAME_EXTENTS),
             XA_CARDINAL, 32, PropModeReplace,
             (unsigned char *)extents, 4
         );
@@ -193,7 +189,7 @@ void enter_portal_fullscreen(Portal *portal)
         }
     );
 
-    XSync(display, False);
+    X_ROUND_TRIP(XSync, display, False);
 }
 
 void exit_portal_fullscreen(Portal *portal)
@@ -209,14 +205,14 @@ void exit_portal_fullscreen(Portal *portal)
     if (has_frame)
     {
         // Calculate client dimensions from backed up portal geometry.
-        unsigned int client_width = portal->geometry_fullscreen_backup.width;
-        unsigned int client_height = portal->geometry_fullscreen_backup.height - PORTAL_TITLE_BAR_HEIGHT;
+        unsigned int client_width = portal->cold->geometry_fullscreen_backup.width;
+        unsigned int client_height = portal->cold->geometry_fullscreen_backup.height - PORTAL_TITLE_BAR_HEIGHT;
 
         // Restore frame position and size.
         XMoveResizeWindow(
             display, portal->frame_window,
-            portal->geometry_fullscreen_backup.x_root, portal->geometry_fullscreen_backup.y_root,
-            portal->geometry_fullscreen_backup.width, portal->geometry_fullscreen_backup.height
+            portal->cold->geometry_fullscreen_backup.x_root, portal->cold->geometry_fullscreen_backup.y_root,
+            portal->cold->geometry_fullscreen_backup.width, portal->cold->geometry_fullscreen_backup.height
         );
 
         // Restore client position within frame (below title bar) and size.
@@ -227,19 +223,19 @@ void exit_portal_fullscreen(Portal *portal)
         );
 
         // Update portal geometry.
-        portal->geometry = portal->geometry_fullscreen_backup;
+        portal->geometry = portal->cold->geometry_fullscreen_backup;
     }
     else
     {
         // Restore client window to backed up position and dimensions.
         XMoveResizeWindow(
             display, portal->client_window,
-            portal->geometry_fullscreen_backup.x_root, portal->geometry_fullscreen_backup.y_root,
-            portal->geometry_fullscreen_backup.width, portal->geometry_fullscreen_backup.height
+            portal->cold->geometry_fullscreen_backup.x_root, portal->cold->geometry_fullscreen_backup.y_root,
+            portal->cold->geometry_fullscreen_backup.width, portal->cold->geometry_fullscreen_backup.height
         );
 
         // Update portal geometry.
-        portal->geometry = portal->geometry_fullscreen_backup;
+        portal->geometry = portal->cold->geometry_fullscreen_backup;
     }
 
     // Unredirect the client window (restore normal frame-based compositing).
@@ -250,23 +246,23 @@ void exit_portal_fullscreen(Portal *portal)
     {
         unsigned long extents[4] = {0, 0, PORTAL_TITLE_BAR_HEIGHT, 0};
         XChangeProperty(
-            display, portal->client_window, _NET_FRAME_EXTENTS,
+            display, portal->client_window, ATOM(_NET_FRAME_EXTENTS),
             XA_CARDINAL, 32, PropModeReplace,
             (unsigned char *)extents, 4
         );
     }
 
     // Calculate client geometry for ConfigureNotify.
-    int restored_x = portal->geometry_fullscreen_backup.x_root;
-    int restored_y = portal->geometry_fullscreen_backup.y_root + (has_frame ? PORTAL_TITLE_BAR_HEIGHT : 0);
-    unsigned int restored_width = portal->geometry_fullscreen_backup.width;
+    int restored_x = portal->cold->geometry_fullscreen_backup.x_root;
+    int restored_y = portal->cold->geometry_fullscreen_backup.y_root + (has_frame ? PORTAL_TITLE_BAR_HEIGHT : 0);
+    unsigned int restored_width = portal->cold->geometry_fullscreen_backup.width;
     unsigned int restored_height = has_frame
-        ? portal->geometry_fullscreen_backup.height - PORTAL_TITLE_BAR_HEIGHT
-        : portal->geometry_fullscreen_backup.height;
+        ? portal->cold->geometry_fullscreen_backup.height - PORTAL_TITLE_BAR_HEIGHT
+        : portal->cold->geometry_fullscreen_backup.height;
 
     // Clear fullscreen state and geometry backup.
     portal->fullscreen = false;
-    portal->geometry_fullscreen_backup = (PortalGeometry){0, 0, 0, 0};
+    portal->cold->geometry_fullscreen_backup = (PortalGeometry){0, 0, 0, 0};
 
     // Update _NET_WM_STATE property to inform the client.
     set_fullscreen_state(portal, false);
@@ -282,15 +278,17 @@ void exit_portal_fullscreen(Portal *portal)
             // Place the portal at its tile slot.
             arrange_workspace_portals(workspace);
         }
-        else if (portal->geometry_floating_backup.width > 0)
+        else if (portal->cold->geometry_floating_backup.width > 0)
         {
             // Restore geometry from backup.
+            begin_portal_transaction();
             resize_portal(portal,
-                portal->geometry_floating_backup.width,
-                portal->geometry_floating_backup.height);
+                portal->cold->geometry_floating_backup.width,
+                portal->cold->geometry_floating_backup.height);
             move_portal(portal,
-                portal->geometry_floating_backup.x_root,
-                portal->geometry_floating_backup.y_root);
+                portal->cold->geometry_floating_backup.x_root,
+                portal->cold->geometry_floating_backup.y_root);
+            commit_portal_transaction();
         }
     }
 
@@ -312,22 +310,14 @@ void exit_portal_fullscreen(Portal *portal)
         }
     );
 
-    XSync(display, False);
-}
-
-HANDLE(Prepare)
-{
-    Display *display = DefaultDisplay;
-    _NET_WM_STATE = XInternAtom(display, "_NET_WM_STATE", False);
-    _NET_WM_STATE_FULLSCREEN = XInternAtom(display, "_NET_WM_STATE_FULLSCREEN", False);
-    _NET_FRAME_EXTENTS = XInternAtom(display, "_NET_FRAME_EXTENTS", False);
+    X_ROUND_TRIP(XSync, display, False);
 }
 
 HANDLE(ClientMessage)
 {
     XClientMessageEvent *xclient = &event->xclient;
 
-    if (xclient->message_type != _NET_WM_STATE) return;
+    if (xclient->message_type != ATOM(_NET_WM_STATE)) return;
 
     // Parse the _NET_WM_STATE request.
     // data.l[0] = action: 0 = remove, 1 = add, 2 = toggle.
@@ -339,8 +329,8 @@ HANDLE(ClientMessage)
 
     // Ensure fullscreen state is being requested.
     bool is_fullscreen_request = (
-        prop1 == _NET_WM_STATE_FULLSCREEN ||
-        prop2 == _NET_WM_STATE_FULLSCREEN
+        prop1 == ATOM(_NET_WM_STATE_FULLSCREEN) ||
+        prop2 == ATOM(_NET_WM_STATE_FULLSCREEN)
     );
     if (!is_fullscreen_request) return;
 
@@ -389,15 +379,15 @@ HANDLE(PortalInitialized)
     unsigned long nitems, bytes_after;
     unsigned char *data = NULL;
 
-    if (XGetWindowProperty(
-        display, portal->client_window, _NET_WM_STATE, 0, 1024, False,
+    if (X_ROUND_TRIP(XGetWindowProperty,
+        display, portal->client_window, ATOM(_NET_WM_STATE), 0, 1024, False,
         XA_ATOM, &actual_type, &actual_format, &nitems,
         &bytes_after, &data) == Success && data != NULL
     ) {
         Atom *states = (Atom *)data;
         for (unsigned long i = 0; i < nitems; i++)
         {
-            if (states[i] == _NET_WM_STATE_FULLSCREEN)
+            if (states[i] == ATOM(_NET_WM_STATE_FULLSCREEN))
             {
                 enter_portal_fullscreen(portal);
                 break;
@@ -0,0 +1,142 @@
+/**
+ * This code is responsible for the portal window index, an open-addressing
+ * hash table (linear probing, backward shift deletion) mapping client and
+ * frame window IDs to their portals.
+ */
+
+#include "../all.h"
+
+typedef struct {
+    Window window;                   // `None` if the slot is empty.
+    PortalWindowRole role;
+    Portal *portal;
+} PortalIndexEntry;
+
+static PortalIndexEntry *index_entries = NULL;
+static unsigned int index_capacity = 0; // Always a power of two.
+static unsigned int index_count = 0;
+
+static unsigned int hash_window(Window window)
+{
+    // Window IDs share their high (client) bits, so spread the low bits with
+    // a Fibonacci multiplicative hash.
+    return (unsigned int)(((uint64_t)window * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static PortalIndexEntry *find_entry(Window window)
+{
+    if (index_capacity == 0) return NULL;
+
+    // Probe from the home slot until the window or an empty slot is found.
+    unsigned int mask = index_capacity - 1;
+    for (unsigned int i = hash_window(window) & mask;; i = (i + 1) & mask)
+    {
+        PortalIndexEntry *entry = &index_entries[i];
+        if (entry->window == window) return entry;
+        if (entry->window == None) return NULL;
+    }
+}
+
+static void insert_entry(PortalIndexEntry entry)
+{
+    // Probe from the home slot until the window or an empty slot is found.
+    unsigned int mask = index_capacity - 1;
+    for (unsigned int i = hash_window(entry.window) & mask;; i = (i + 1) & mask)
+    {
+        if (index_entries[i].window == entry.window)
+        {
+            index_entries[i] = entry;
+            return;
+        }
+        if (index_entries[i].window == None)
+        {
+            index_entries[i] = entry;
+            index_count++;
+            return;
+        }
+    }
+}
+
+static int grow_index()
+{
+    // Allocate the new, twice as large, slot array.
+    unsigned int new_capacity = (index_capacity == 0)
+        ? PORTAL_INDEX_INITIAL_CAPACITY
+        : index_capacity * 2;
+    PortalIndexEntry *new_entries = calloc(new_capacity, sizeof(PortalIndexEntry));
+    if (new_entries == NULL) return -1;
+
+    // Rehash the existing entries into the new slot array.
+    PortalIndexEntry *old_entries = index_entries;
+    unsigned int old_capacity = index_capacity;
+    index_entries = new_entries;
+    index_capacity = new_capacity;
+    index_count = 0;
+    for (unsigned int i = 0; i < old_capacity; i++)
+    {
+        if (old_entries[i].window != None) insert_entry(old_entries[i]);
+    }
+    free(old_entries);
+
+    return 0;
+}
+
+int index_portal_window(Portal *portal, Window window, PortalWindowRole role)
+{
+    if (window == None) return -1;
+
+    // Keep the load factor at or below one half, so probes stay short.
+    if ((index_count + 1) * 2 > index_capacity && grow_index() != 0)
+    {
+        LOG_ERROR("Could not index portal window, memory allocation failed.");
+        return -2;
+    }
+
+    // Add (or update) the entry.
+    insert_entry((PortalIndexEntry){
+        .window = window,
+        .role = role,
+        .portal = portal
+    });
+
+    return 0;
+}
+
+void unindex_portal_window(Window window)
+{
+    if (window == None) return;
+
+    // Find the entry of the window.
+    PortalIndexEntry *entry = find_entry(window);
+    if (entry == NULL) return;
+
+    // Empty the slot, then shift subsequent entries of the probe sequence
+    // back into it, so lookups never stop early at the emptied slot.
+    unsigned int mask = index_capacity - 1;
+    unsigned int hole = (unsigned int)(entry - index_entries);
+    index_entries[hole].window = None;
+    index_count--;
+    for (unsigned int i = (hole + 1) & mask; index_entries[i].window != None; i = (i + 1) & mask)
+    {
+        // Only move entries whose home slot doesn't lie between the hole
+        // and their current slot (cyclically).
+        unsigned int home = hash_window(index_entries[i].window) & mask;
+        if (((i - home) & mask) < ((i - hole) & mask)) continue;
+
+        index_entries[hole] = index_entries[i];
+        index_entries[i].window = None;
+        hole = i;
+    }
+}
+
+Portal *lookup_portal_window(Window window, PortalWindowRole *out_role)
+{
+    if (window == None) return NULL;
+
+    // Find the entry of the window.
+    PortalIndexEntry *entry = find_entry(window);
+    if (entry == NULL) return NULL;
+
+    if (out_role != NULL) *out_role = entry->role;
+    return entry->portal;
+}
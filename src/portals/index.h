@@ -0,0 +1,47 @@
+#pragma once
+#include "../all.h"
+
+/** The initial number of slots in the portal window index. */
+#define PORTAL_INDEX_INITIAL_CAPACITY 64
+
+/** A type representing the role a window plays within its portal. */
+typedef enum
+{
+    /** The client window of the portal. */
+    PORTAL_WINDOW_CLIENT,
+    /** The frame window of the portal. */
+    PORTAL_WINDOW_FRAME
+} PortalWindowRole;
+
+/**
+ * Adds a window to the portal window index.
+ *
+ * @param portal The portal the window belongs to.
+ * @param window The window to add.
+ * @param role The role the window plays within the portal.
+ *
+ * @return - `0` The window was added (or updated) successfully.
+ * @return - `-1` The window is `None`.
+ * @return - `-2` The index could not be grown, memory allocation failed.
+ */
+int index_portal_window(Portal *portal, Window window, PortalWindowRole role);
+
+/**
+ * Removes a window from the portal window index.
+ *
+ * @param window The window to remove.
+ *
+ * @note Has no effect if the window is not indexed.
+ */
+void unindex_portal_window(Window window);
+
+/**
+ * Looks up the portal a window belongs to in the portal window index.
+ *
+ * @param window A client or frame window.
+ * @param out_role Pointer to store the role of the window, or `NULL`.
+ *
+ * @return - `Portal*` The portal the window belongs to.
+ * @return - `NULL` The window is not indexed.
+ */
+Portal *lookup_portal_window(Window window, PortalWindowRole *out_role);
@@ -2,8 +2,9 @@
  * Central dispatcher for portal interaction events.
  *
  * This module routes portal interaction events to the appropriate handlers
- * (dragging, resizing, triggers). It consolidates event handling, eliminates
- * duplicate XQueryPointer calls, and centralizes cursor management.
+ * (dragging, resizing, triggers). It consolidates event handling, relies on
+ * the tracked pointer position (resynchronized once per click), and
+ * centralizes cursor management.
  */
 
 #include "../all.h"
@@ -11,26 +12,17 @@
 HANDLE(RawButtonPress)
 {
     RawButtonPressEvent *_event = &event->raw_button_press;
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
 
-    // Get the pointer's current position and the window under the cursor.
+    // Resynchronize the tracked position before hit-testing the click, as
+    // pointer warps produce no raw motion and may have left it out of date.
+    synchronize_pointer();
+
+    // Get the pointer's tracked position.
     int pointer_x_root = 0, pointer_y_root = 0;
-    Window child_window = None;
-    XQueryPointer(
-        display,            // Display
-        root_window,        // Window
-        &(Window){0},       // Root (Unused)
-        &child_window,      // Child (the window under cursor)
-        &pointer_x_root,    // Pointer X (Relative to root)
-        &pointer_y_root,    // Pointer Y (Relative to root)
-        &(int){0},          // Window X (Unused)
-        &(int){0},          // Window Y (Unused)
-        &(unsigned int){0}  // Mask (Unused)
-    );
-
-    // Find the portal that owns the window under the cursor.
-    Portal *portal = find_portal_by_window(child_window);
+    get_pointer_position(&pointer_x_root, &pointer_y_root);
+
+    // Find the portal under the cursor.
+    Portal *portal = get_portal_under_pointer();
     if (portal == NULL) return;
 
     // Skip override-redirect portals (popups, dropdowns, menus).
@@ -99,25 +91,11 @@ HANDLE(RawButtonRelease)
     }
 }
 
-HANDLE(RawMotionNotify)
+HANDLE(PointerMoved)
 {
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
-
-    // Get the current pointer position since RawMotionNotify doesn't include it.
-    int pointer_x_root = 0, pointer_y_root = 0;
-    Window child_window = None;
-    XQueryPointer(
-        display,            // Display
-        root_window,        // Window
-        &(Window){0},       // Root (Unused)
-        &child_window,      // Child
-        &pointer_x_root,    // Pointer X (Relative to root)
-        &pointer_y_root,    // Pointer Y (Relative to root)
-        &(int){0},          // Window X (Unused)
-        &(int){0},          // Window Y (Unused)
-        &(unsigned int){0}  // Mask (Unused)
-    );
+    PointerMovedEvent *_event = &event->pointer_moved;
+    int pointer_x_root = _event->x_root;
+    int pointer_y_root = _event->y_root;
 
     // Handle active dragging.
     if (is_portal_dragging())
@@ -136,7 +114,7 @@ HANDLE(RawMotionNotify)
     }
 
     // Handle hover cursors.
-    Portal *portal = find_portal_by_window(child_window);
+    Portal *portal = find_portal_at_pos(pointer_x_root, pointer_y_root);
     bool in_resize_area = false;
     bool in_frame_area = false;
     bool in_trigger_area = false;
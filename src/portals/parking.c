@@ -0,0 +1,173 @@
+/**
+ * This code is responsible for parking portals on inactive workspaces. A
+ * parked portal stays mapped, so the X server keeps its composite pixmap
+ * and switching back shows its content without the client repainting, but
+ * it is excluded from composition and its input shape is emptied.
+ */
+
+#include "../all.h"
+
+/** Whether portals are parked when suspended, rather than unmapped. */
+static bool parking_enabled = false;
+
+/** The memory in bytes that parked portals may take up. */
+static uint64_t parking_memory_cap = 0;
+
+/** The order in which portals were parked, used to find the oldest ones. */
+static unsigned long park_sequence = 0;
+
+/** Whether the memory cap must be enforced once the current batch ends. */
+static bool memory_cap_pending = false;
+
+/** An empty region, used as the input shape of parked portals. */
+static XserverRegion empty_region = None;
+
+static Window get_outermost_window(Portal *portal)
+{
+    return is_portal_frame_valid(portal) ? portal->frame_window : portal->client_window;
+}
+
+static uint64_t estimate_portal_memory(Portal *portal)
+{
+    // Estimate the composite pixmaps at 4 bytes per pixel, counting the
+    // separately redirected client of framed portals twice.
+    uint64_t size = (uint64_t)portal->geometry.width * portal->geometry.height * 4;
+    return is_portal_frame_valid(portal) ? size * 2 : size;
+}
+
+static void evict_portal(Portal *portal)
+{
+    Display *display = DefaultDisplay;
+
+    // Unmap the outermost window, as a non-parked suspend would have.
+    unpark_portal(portal);
+    XUnmapWindow(display, get_outermost_window(portal));
+}
+
+static void enforce_parking_memory_cap()
+{
+    // Sum the memory of the parked portals per workspace, and find the
+    // least recent park of each workspace.
+    uint64_t total = 0;
+    uint64_t workspace_memory[MAX_WORKSPACES] = {0};
+    unsigned long workspace_sequence[MAX_WORKSPACES] = {0};
+    unsigned int portal_count = 0;
+    Portal **portals = get_active_portals(&portal_count);
+    for (unsigned int i = 0; i < portal_count; i++)
+    {
+        Portal *portal = portals[i];
+        if (!portal->parked) continue;
+        if (portal->workspace < 0 || portal->workspace >= MAX_WORKSPACES) continue;
+        uint64_t memory = estimate_portal_memory(portal);
+        total += memory;
+        workspace_memory[portal->workspace] += memory;
+        unsigned long *sequence = &workspace_sequence[portal->workspace];
+        if (*sequence == 0 || portal->cold->parked_sequence < *sequence)
+        {
+            *sequence = portal->cold->parked_sequence;
+        }
+    }
+
+    // Pick the least recently parked workspaces until the rest fit the cap,
+    // as a partially parked workspace would still repaint when switched to.
+    bool evicted[MAX_WORKSPACES] = {false};
+    bool any_evicted = false;
+    while (total > parking_memory_cap)
+    {
+        int oldest = -1;
+        for (int i = 0; i < MAX_WORKSPACES; i++)
+        {
+            if (evicted[i] || workspace_sequence[i] == 0) continue;
+            if (oldest == -1 || workspace_sequence[i] < workspace_sequence[oldest]) oldest = i;
+        }
+        if (oldest == -1) break;
+        evicted[oldest] = true;
+        any_evicted = true;
+        total -= workspace_memory[oldest];
+    }
+    if (!any_evicted) return;
+
+    // Unmap all parked portals of the picked workspaces.
+    for (unsigned int i = 0; i < portal_count; i++)
+    {
+        Portal *portal = portals[i];
+        if (!portal->parked) continue;
+        if (portal->workspace < 0 || portal->workspace >= MAX_WORKSPACES) continue;
+        if (!evicted[portal->workspace]) continue;
+        evict_portal(portal);
+    }
+}
+
+bool is_portal_parking_enabled()
+{
+    return parking_enabled && is_compositor_enabled();
+}
+
+int park_portal(Portal *portal)
+{
+    // Parked portals are only hidden from view by the compositor.
+    if (!is_portal_parking_enabled()) return -1;
+    if (portal->parked) return 0;
+    Display *display = DefaultDisplay;
+
+    // Create the empty region on first use.
+    if (empty_region == None)
+    {
+        empty_region = XFixesCreateRegion(display, NULL, 0);
+    }
+
+    // Empty the input shape of the outermost window, which clips the input
+    // of its children as well.
+    XFixesSetWindowShapeRegion(display, get_outermost_window(portal), ShapeInput, 0, 0, empty_region);
+    portal->parked = true;
+    portal->cold->parked_sequence = ++park_sequence;
+
+    // Fall back to unmapping the least recently parked workspaces, once the
+    // batch in progress (if any) ends.
+    if (!is_portal_batch_in_progress())
+    {
+        enforce_parking_memory_cap();
+    }
+    else
+    {
+        memory_cap_pending = true;
+    }
+    return 0;
+}
+
+void unpark_portal(Portal *portal)
+{
+    if (!portal->parked) return;
+
+    // Restore the default input shape of the outermost window.
+    XFixesSetWindowShapeRegion(DefaultDisplay, get_outermost_window(portal), ShapeInput, 0, 0, None);
+    portal->parked = false;
+}
+
+HANDLE(Initialize)
+{
+    // Read whether portals are parked from config.
+    char enabled_value[CONFIG_MAX_VALUE_LENGTH];
+    common.get_config_str(
+        enabled_value, sizeof(enabled_value),
+        CFG_KEY_KEEP_WORKSPACES_MAPPED, CFG_DEFAULT_KEEP_WORKSPACES_MAPPED
+    );
+    parking_enabled = (strcmp(enabled_value, "true") == 0);
+
+    // Read the parking memory cap from config.
+    char cap_value[CONFIG_MAX_VALUE_LENGTH];
+    common.get_config_str(
+        cap_value, sizeof(cap_value),
+        CFG_KEY_MAPPED_WORKSPACES_MEMORY_CAP, CFG_DEFAULT_MAPPED_WORKSPACES_MEMORY_CAP
+    );
+    int cap_mb = atoi(cap_value);
+    if (cap_mb < 0) cap_mb = 0;
+    parking_memory_cap = (uint64_t)cap_mb * 1024 * 1024;
+}
+
+HANDLE(PortalBatchEnded)
+{
+    if (!memory_cap_pending) return;
+    memory_cap_pending = false;
+    enforce_parking_memory_cap();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "../all.h"
+
+/**
+ * Checks whether portals are parked when suspended, rather than unmapped.
+ *
+ * @return - `true` Parking is enabled in the configuration, and the
+ * compositor is enabled.
+ * @return - `false` Parking is disabled.
+ */
+bool is_portal_parking_enabled();
+
+/**
+ * Parks a visible portal that is being suspended: its windows stay mapped,
+ * and thereby keep their content, but its input shape is emptied. Parked
+ * portals are excluded from composition as they aren't visible.
+ *
+ * @param portal The portal to park.
+ *
+ * @return - `0` The portal was parked.
+ * @return - `-1` Parking is disabled, or the compositor is disabled, the
+ * portal must be unmapped instead.
+ *
+ * @note Once parked portals exceed the configured memory cap, the portals of
+ * the least recently parked workspaces are unmapped until they fit again.
+ * Within a portal batch, the cap is enforced once the batch ends.
+ */
+int park_portal(Portal *portal);
+
+/**
+ * Unparks a parked portal, restoring its input shape.
+ *
+ * @param portal The portal to unpark.
+ *
+ * @note Has no effect if the portal is not parked.
+ */
+void unpark_portal(Portal *portal);
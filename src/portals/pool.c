@@ -0,0 +1,74 @@
+/**
+ * This code is responsible for the portal pool, a slab allocator handing out
+ * portals with stable addresses. Slabs are allocated as needed and never
+ * freed, released portals are reused by later allocations.
+ *
+ * Each slab stores the portals contiguously, and their cold state in a
+ * separate array, so scans over portals only touch their frequently accessed
+ * state. A bitmap per slab tracks which of its portals are allocated.
+ */
+
+#include "../all.h"
+
+typedef struct {
+    Portal portals[PORTAL_POOL_SLAB_SIZE];
+    PortalColdState cold[PORTAL_POOL_SLAB_SIZE];
+    uint64_t allocated;              // Bit set for each allocated portal.
+} PortalSlab;
+
+static PortalSlab **slabs = NULL;
+static unsigned int slab_count = 0;
+
+/** The first slab which may have an unallocated portal. */
+static unsigned int first_free_slab = 0;
+
+static int grow_pool()
+{
+    // Allocate the new slab, and register it.
+    PortalSlab **new_slabs = realloc(slabs, (slab_count + 1) * sizeof(PortalSlab *));
+    if (new_slabs == NULL) return -1;
+    slabs = new_slabs;
+    PortalSlab *slab = calloc(1, sizeof(PortalSlab));
+    if (slab == NULL) return -1;
+    slabs[slab_count++] = slab;
+    return 0;
+}
+
+Portal *allocate_portal()
+{
+    // Find a slab with an unallocated portal, growing the pool if none has.
+    while (first_free_slab < slab_count && slabs[first_free_slab]->allocated == UINT64_MAX)
+    {
+        first_free_slab++;
+    }
+    if (first_free_slab == slab_count && grow_pool() != 0) return NULL;
+    PortalSlab *slab = slabs[first_free_slab];
+
+    // Allocate the lowest unallocated portal in the slab.
+    int index = __builtin_ctzll(~slab->allocated);
+    slab->allocated |= (uint64_t)1 << index;
+
+    // Reset the portal, and assign it its cold state.
+    Portal *portal = &slab->portals[index];
+    *portal = (Portal){0};
+    slab->cold[index] = (PortalColdState){0};
+    portal->cold = &slab->cold[index];
+    return portal;
+}
+
+void release_portal(Portal *portal)
+{
+    // Find the slab containing the portal.
+    for (unsigned int i = 0; i < slab_count; i++)
+    {
+        PortalSlab *slab = slabs[i];
+        if (portal < slab->portals || portal >= slab->portals + PORTAL_POOL_SLAB_SIZE) continue;
+
+        // Mark the portal as unallocated, keeping its memory, so pointers to
+        // it still read as an inactive portal.
+        int index = portal - slab->portals;
+        slab->allocated &= ~((uint64_t)1 << index);
+        if (i < first_free_slab) first_free_slab = i;
+        return;
+    }
+}
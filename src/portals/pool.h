@@ -0,0 +1,29 @@
+#pragma once
+#include "../all.h"
+
+/**
+ * The number of portals in each slab of the portal pool, matching the width
+ * of the bitmap of allocated portals in a slab.
+ */
+#define PORTAL_POOL_SLAB_SIZE 64
+
+/**
+ * Allocates a portal from the portal pool, growing the pool by a slab if no
+ * released portal is available.
+ *
+ * @return - `Portal*` The allocated portal, zeroed, with its `cold` state
+ * assigned and zeroed.
+ * @return - `NULL` The pool could not be grown, memory allocation failed.
+ *
+ * @note Portals never move, pointers to them stay valid until released, and
+ * point to an inactive portal until reused afterwards.
+ */
+Portal *allocate_portal();
+
+/**
+ * Releases a portal back to the portal pool, for reuse by a later
+ * `allocate_portal()` call.
+ *
+ * @param portal The portal to release.
+ */
+void release_portal(Portal *portal);
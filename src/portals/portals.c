@@ -1,19 +1,54 @@
 #include "../all.h"
 
 typedef struct {
-    Portal unsorted[MAX_PORTALS];
-    Portal *sorted[MAX_PORTALS];
+    Portal **active;                 // Active portals, in creation order.
+    Portal **sorted;                 // Sorted portals, in stacking order.
+    unsigned int capacity;           // Capacity of both arrays.
+    unsigned int sorted_count;
     unsigned int active_count;
 } PortalRegistry;
 
 static PortalRegistry registry = {
-    .unsorted = {{.active = false}},
-    .sorted = {NULL},
+    .active = NULL,
+    .sorted = NULL,
+    .capacity = 0,
+    .sorted_count = 0,
     .active_count = 0
 };
 
 static Portal *top_portal = NULL;
 
+/** The nesting depth of the geometry transaction in progress, if any. */
+static int transaction_depth = 0;
+
+/** The nesting depth of the portal batch in progress, if any. */
+static int batch_depth = 0;
+
+/** Whether existing windows are being adopted, see `adopt_existing_portal_windows()`. */
+static bool adopting = false;
+
+/** The outcome of adopting existing windows, see `report_portal_adoption()`. */
+static unsigned int adoption_count = 0;
+static uint64_t adoption_duration_us = 0;
+
+static int ensure_registry_capacity(unsigned int count)
+{
+    if (count <= registry.capacity) return 0;
+
+    // Double the capacity of both arrays, so all active portals always fit
+    // in the sorted array as well.
+    unsigned int new_capacity = (registry.capacity > 0) ? registry.capacity * 2 : PORTAL_POOL_SLAB_SIZE;
+    while (new_capacity < count) new_capacity *= 2;
+    Portal **new_active = realloc(registry.active, new_capacity * sizeof(Portal *));
+    if (new_active == NULL) return -1;
+    registry.active = new_active;
+    Portal **new_sorted = realloc(registry.sorted, new_capacity * sizeof(Portal *));
+    if (new_sorted == NULL) return -1;
+    registry.sorted = new_sorted;
+    registry.capacity = new_capacity;
+    return 0;
+}
+
 static void raise_portal_window(Portal *portal)
 {
     // Determine which window to raise.
@@ -21,8 +56,9 @@ static void raise_portal_window(Portal *portal)
         ? portal->frame_window
         : portal->client_window;
 
-    // Raise the window.
+    // Raise the window, mirroring the new stacking order right away.
     XRaiseWindow(DefaultDisplay, target_window);
+    raise_stacked_window(target_window);
 }
 
 void initialize_portal(Portal *portal)
@@ -30,68 +66,60 @@ void initialize_portal(Portal *portal)
     Display *display = DefaultDisplay;
     Window client_window = portal->client_window;
 
-    // Determine the portal title, based on the client window name.
-    char portal_title[256] = "Untitled";
-    x_get_window_name(display, client_window, portal_title, sizeof(portal_title));
+    // Fetch the client window state and properties in a single batch, unless
+    // they were fetched beforehand.
+    populate_portal_properties(portal);
+    PortalProperties *properties = &portal->cold->properties;
 
-    // Set the portal title.
-    char *new_title = strdup(portal_title);
+    // Set the portal title, based on the client window name.
+    char *new_title = strdup(properties->title);
     if (new_title != NULL)
     {
-        free(portal->title);
-        portal->title = new_title;
+        free(portal->cold->title);
+        portal->cold->title = new_title;
     }
 
-    // Determine whether the portal is top-level.
-    portal->top_level = x_window_is_top_level(display, portal->client_window);
+    // Determine whether the portal is top-level (ICCCM).
+    Window root_window = DefaultRootWindow(display);
+    portal->top_level = (properties->parent == root_window && !properties->override_redirect);
 
-    // Query the client window type (e.g. tooltip, notification, normal).
-    portal->client_window_type = x_get_window_type(display, portal->client_window);
+    // Store the client window type (e.g. tooltip, notification, normal).
+    portal->client_window_type = properties->window_type;
 
-    // Get the client window's geometry and visual BEFORE creating the frame.
-    // This must be done while the client is still a child of root,
-    // otherwise the coordinates will be wrong after reparenting.
-    Window root_window = DefaultRootWindow(display);
-    int client_x_root = 0, client_y_root = 0;
-    unsigned int client_width = 1, client_height = 1;
-    XTranslateCoordinates(
-        display,        // Display
-        client_window,  // Source window
-        root_window,    // Reference window
-        0, 0,           // Source window origin coordinates
-        &client_x_root, // Translated X coordinate
-        &client_y_root, // Translated Y coordinate
-        &(Window){0}    // Child window (Unused)
-    );
-    XWindowAttributes client_attrs;
-    if (XGetWindowAttributes(display, client_window, &client_attrs))
-    {
-        client_width = client_attrs.width;
-        client_height = client_attrs.height;
-        portal->client_visual = client_attrs.visual;
-        portal->override_redirect = client_attrs.override_redirect;
-    }
+    // Store the client window's geometry and visual BEFORE creating the frame.
+    // The client is still a child of root, so its position is root-relative.
+    int client_x_root = properties->x;
+    int client_y_root = properties->y;
+    unsigned int client_width = (properties->width > 0) ? properties->width : 1;
+    unsigned int client_height = (properties->height > 0) ? properties->height : 1;
+    portal->cold->client_visual = properties->visual;
+    portal->override_redirect = properties->override_redirect;
 
     // Remove the border from the client window, as the window manager will
     // be responsible for handling all window decorations. Skip InputOnly
     // windows (e.g. GTK grab windows) which don't support border changes.
-    if (client_attrs.class != InputOnly)
+    if (properties->window_class != InputOnly)
     {
         XSetWindowBorderWidth(display, client_window, 0);
     }
 
+    // Set the portal geometry from the client window geometry, from here on
+    // it is kept current by the WM itself and by configure events.
+    portal->geometry.x_root = client_x_root;
+    portal->geometry.y_root = client_y_root;
+    portal->geometry.width = client_width;
+    portal->geometry.height = client_height;
+
     // Create a frame for the portal, if necessary.
     if (should_portal_be_framed(portal))
     {
-        // Set the portal geometry before creating the frame, so the frame
+        // Extend the portal geometry before creating the frame, so the frame
         // is created with the correct position and dimensions.
-        portal->geometry.x_root = client_x_root;
-        portal->geometry.y_root = client_y_root;
-        portal->geometry.width = client_width;
         portal->geometry.height = client_height + PORTAL_TITLE_BAR_HEIGHT;
 
         create_portal_frame(portal);
     }
+    portal->cold->geometry_committed = portal->geometry;
 
     // Set the portal as initialized.
     portal->initialized = true;
@@ -106,21 +134,12 @@ void initialize_portal(Portal *portal)
 Portal *create_portal(Window client_window)
 {
     // Choose which client window events we should listen for.
-    XSelectInput(DefaultDisplay, client_window, SubstructureNotifyMask);
+    XSelectInput(DefaultDisplay, client_window, SubstructureNotifyMask | PropertyChangeMask | FocusChangeMask);
 
-    // Find the first inactive slot in the registry.
-    int slot = -1;
-    for (int i = 0; i < MAX_PORTALS; i++)
-    {
-        if (!registry.unsorted[i].active)
-        {
-            slot = i;
-            break;
-        }
-    }
-    if (slot == -1)
+    // Ensure the registry can hold another portal.
+    if (ensure_registry_capacity(registry.active_count + 1) != 0)
     {
-        LOG_ERROR("Could not register portal, maximum portal count reached.");
+        LOG_ERROR("Could not register portal, memory allocation failed.");
         return NULL;
     }
 
@@ -132,10 +151,32 @@ Portal *create_portal(Window client_window)
         return NULL;
     }
 
-    // Add the portal to the registry.
-    registry.unsorted[slot] = (Portal){
-        .active = true,
+    // Allocate the portal from the pool.
+    Portal *portal = allocate_portal();
+    if (portal == NULL)
+    {
+        LOG_ERROR("Could not register portal, memory allocation failed.");
+        free(title);
+        return NULL;
+    }
+
+    // Initialize the portal, keeping the cold state assigned by the pool.
+    PortalColdState *cold = portal->cold;
+    *cold = (PortalColdState){
         .title = title,
+        .geometry_fullscreen_backup = {0, 0, 0, 0},
+        .geometry_floating_backup = {0, 0, 0, 0},
+        .geometry_committed = {0, 0, 1, 1},
+        .configure_serial = 0,
+        .frame_cr = NULL,
+        .frame_visual = NULL,
+        .client_visual = NULL,
+        .properties = {.fetched = false},
+        .parked_sequence = 0,
+        .redirected_client = None
+    };
+    *portal = (Portal){
+        .active = true,
         .client_window_type = None,
         .transient_for = NULL,
         .initialized = false,
@@ -144,20 +185,22 @@ Portal *create_portal(Window client_window)
         .fullscreen = false,
         .workspace = -1,
         .geometry = {0, 0, 1, 1},
-        .geometry_fullscreen_backup = {0, 0, 0, 0},
-        .geometry_floating_backup = {0, 0, 0, 0},
+        .transform_pending = false,
         .frame_window = None,
-        .frame_cr = NULL,
+        .frame_alive = false,
         .client_window = client_window,
-        .client_visual = NULL,
-        .frame_visual = NULL
+        .client_alive = true,
+        .client_parent = DefaultRootWindow(DefaultDisplay),
+        .parked = false,
+        .surface_failed = false,
+        .cold = cold
     };
 
-    // Store the portal in a variable for easier access.
-    Portal *portal = &registry.unsorted[slot];
+    // Index the client window, so the portal can be found by it.
+    index_portal_window(portal, client_window, PORTAL_WINDOW_CLIENT);
 
-    // Increment active count.
-    registry.active_count++;
+    // Add the portal to the active portals.
+    registry.active[registry.active_count++] = portal;
 
     // Call all event handlers of the PortalCreated event.
     call_event_handlers((Event*)&(PortalCreatedEvent){
@@ -195,141 +238,189 @@ void destroy_portal(Portal *portal)
     });
 
     // Clear transient references to this portal.
-    for (int i = 0; i < MAX_PORTALS; i++)
+    for (unsigned int i = 0; i < registry.active_count; i++)
     {
-        if (!registry.unsorted[i].active) continue;
-        if (registry.unsorted[i].transient_for == portal)
+        if (registry.active[i]->transient_for == portal)
         {
-            registry.unsorted[i].transient_for = NULL;
+            registry.active[i]->transient_for = NULL;
         }
     }
 
     // Free the allocated memory for the title.
-    free(portal->title);
-    portal->title = NULL;
+    free(portal->cold->title);
+    portal->cold->title = NULL;
 
-    // Mark the portal slot as inactive (tombstone).
-    portal->active = false;
+    // Remove the remaining portal windows from the index.
+    unindex_portal_window(portal->client_window);
+    unindex_portal_window(portal->frame_window);
+
+    // Remove the portal from the active portals, preserving their order.
+    for (unsigned int i = 0; i < registry.active_count; i++)
+    {
+        if (registry.active[i] != portal) continue;
+        memmove(
+            &registry.active[i],
+            &registry.active[i + 1],
+            (registry.active_count - i - 1) * sizeof(Portal *)
+        );
+        registry.active_count--;
+        break;
+    }
 
-    // Decrease the active count.
-    registry.active_count--;
+    // Mark the portal as inactive and release it to the pool.
+    portal->active = false;
+    release_portal(portal);
 
     // Re-sort the portals.
     sort_portals();
 }
 
-void move_portal(Portal *portal, int x_root, int y_root)
+static bool get_portal_parent_origin(Portal *portal, int *out_x_root, int *out_y_root)
 {
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
-
-    // Ensure the portal has been initialized.
-    if (portal->initialized == false) return;
-
-    // Move the portal itself.
-    portal->geometry.x_root = x_root;
-    portal->geometry.y_root = y_root;
+    Window root_window = DefaultRootWindow(DefaultDisplay);
 
-    // Move the portal windows.
+    // Frames, and unframed clients, are normally direct children of root.
+    Window parent_window = (portal->frame_window != None)
+        ? root_window
+        : portal->client_parent;
+    if (parent_window == root_window)
     {
-        Window client_window = portal->client_window;
-        Window frame_window = portal->frame_window;
+        *out_x_root = 0;
+        *out_y_root = 0;
+        return true;
+    }
 
-        // Determine which window to move.
-        Window target_window = (is_portal_frame_valid(portal)) ? frame_window : client_window;
+    // Otherwise the parent must be a known portal window.
+    Portal *parent = find_portal_by_window(parent_window);
+    if (parent == NULL) return false;
+    *out_x_root = parent->geometry.x_root;
+    *out_y_root = parent->geometry.y_root;
+    if (parent_window == parent->client_window && parent->frame_window != None)
+    {
+        *out_y_root += PORTAL_TITLE_BAR_HEIGHT;
+    }
+    return true;
+}
 
-        // Check if the target window still exists (may have been destroyed).
-        if (!x_window_exists(display, target_window)) return;
+static void apply_portal_transform(Portal *portal)
+{
+    Display *display = DefaultDisplay;
+    PortalGeometry *geometry = &portal->geometry;
+    PortalGeometry *committed = &portal->cold->geometry_committed;
+
+    // Skip the portal if its geometry ended up unchanged.
+    bool moved = (geometry->x_root != committed->x_root ||
+        geometry->y_root != committed->y_root);
+    bool resized = (geometry->width != committed->width ||
+        geometry->height != committed->height);
+    if (!moved && !resized)
+    {
+        portal->transform_pending = false;
+        return;
+    }
 
-        // The `XMoveWindow()` function expects coordinates relative to the
-        // parent window. So we have to translate the provided root coordinates
-        // to parent coordinates.
+    Window client_window = portal->client_window;
+    Window frame_window = portal->frame_window;
+    bool is_framed = (frame_window != None);
 
-        // Retrieve the parent window of the target window.
-        Window parent_window = x_get_window_parent(display, target_window);
-        if (parent_window == None)
-        {
-            // Window was likely destroyed between the exists check and now.
-            return;
-        }
+    // Determine which window to configure.
+    Window target_window = (is_framed) ? frame_window : client_window;
+    if (target_window == None)
+    {
+        portal->transform_pending = false;
+        return;
+    }
 
-        // Calculate the parent window coordinates relative to root.
-        int parent_x_root = -1, parent_y_root = -1;
-        XTranslateCoordinates(
-            display,        // Display
-            parent_window,  // Source window
-            root_window,    // Reference window
-            0, 0,           // Source window origin coordinates
-            &parent_x_root, // Translated X coordinate
-            &parent_y_root, // Translated Y coordinate
-            &(Window){0}    // Child window (Unused)
+    // The configure requests expect coordinates relative to the parent
+    // window. So we have to translate the root coordinates to parent
+    // coordinates, using the WM-tracked window hierarchy. Keep the change
+    // pending if the parent is unknown, so it is applied against the same
+    // baseline once the parent is known, see `HANDLE(ReparentNotify)`.
+    int parent_x_root = 0, parent_y_root = 0;
+    if (moved && !get_portal_parent_origin(portal, &parent_x_root, &parent_y_root))
+    {
+        LOG_WARNING(
+            "Could not move portal (%p) yet, parent window is unknown.",
+            (void*)portal
         );
-        if (parent_x_root == -1 || parent_y_root == -1)
-        {
-            LOG_ERROR(
-                "Could not move portal (%p), coordinate translation failed.",
-                (void*)portal
-            );
-            return;
-        }
+        return;
+    }
+    portal->transform_pending = false;
 
-        // Calculate target window coordinates relative to parent.
-        int x_parent = x_root - parent_x_root;
-        int y_parent = y_root - parent_y_root;
+    // Calculate the client window dimensions.
+    unsigned int client_width = common.int_max(1, geometry->width);
+    unsigned int client_height = (is_framed)
+        ? common.int_max(1, geometry->height - PORTAL_TITLE_BAR_HEIGHT)
+        : common.int_max(1, geometry->height);
 
-        // Move the target window.
-        XMoveWindow(display, target_window, x_parent, y_parent);
+    // The windows may be destroyed at any moment by their client, so ignore
+    // the errors caused by the requests below instead of checking first.
+    unsigned long first_request = x_begin_error_range(display, NULL, NULL);
 
-        // According to the ICCCM (Sections 4.1.5 and 4.2.3), when a window
-        // manager moves a reparented client window, it is responsible for
-        // sending a synthetic ConfigureNotify event to the client with the
-        // windows new dimensions and position relative to root.
+    // Remember the serial of the configure requests, so configure events
+    // generated before them can be recognized as outdated.
+    portal->cold->configure_serial = first_request;
 
-        if (is_portal_frame_valid(portal))
+    if (moved)
+    {
+        // Calculate target window coordinates relative to parent.
+        int x_parent = geometry->x_root - parent_x_root;
+        int y_parent = geometry->y_root - parent_y_root;
+
+        // Move (and resize) the target window in a single request.
+        if (resized)
         {
-            // Retrieve the client window dimensions.
-            unsigned int client_width = 0, client_height = 0;
-            Status geometry_status = XGetGeometry(
-                display,            // Display
-                client_window,      // Drawable
-                &(Window){0},       // Root window (Unused)
-                &(int){0},          // X (Relative to parent) (Unused)
-                &(int){0},          // Y (Relative to parent) (Unused)
-                &client_width,      // Width
-                &client_height,     // Height
-                &(unsigned int){0}, // Border width (Unused)
-                &(unsigned int){0}  // Depth (Unused)
+            XMoveResizeWindow(
+                display, target_window, x_parent, y_parent,
+                common.int_max(1, geometry->width),
+                common.int_max(1, geometry->height)
             );
-            if (geometry_status == 0)
-            {
-                LOG_ERROR(
-                    "Could not move portal (%p), "
-                    "client window dimensions unavailable.",
-                    (void*)portal
-                );
-                return;
-            }
+        }
+        else
+        {
+            XMoveWindow(display, target_window, x_parent, y_parent);
+        }
+    }
+    else
+    {
+        // Resize the target window.
+        XResizeWindow(
+            display, target_window,
+            common.int_max(1, geometry->width),
+            common.int_max(1, geometry->height)
+        );
+    }
 
-            // Notify the client window of its new geometry.
-            XSendEvent(display, client_window, False, StructureNotifyMask, (XEvent*)&(XConfigureEvent) {
-                .type = ConfigureNotify,
-                .display = display,
-                .event = client_window,
-                .window = client_window,
-                .x = x_root,
-                .y = y_root + PORTAL_TITLE_BAR_HEIGHT,
-                .width = client_width,
-                .height = client_height,
-                .border_width = 0,
-                .above = None,
-                .override_redirect = False
-            });
-
-            // Process all pending X events.
-            XSync(display, False);
+    if (is_framed)
+    {
+        // Resize the client window along with the frame.
+        if (resized)
+        {
+            XResizeWindow(display, client_window, client_width, client_height);
         }
+
+        // According to the ICCCM (Sections 4.1.5 and 4.2.3), when a window
+        // manager moves or resizes a reparented client window, it is
+        // responsible for sending a synthetic ConfigureNotify event to the
+        // client with the windows new dimensions and position relative to
+        // root.
+        XSendEvent(display, client_window, False, StructureNotifyMask, (XEvent*)&(XConfigureEvent) {
+            .type = ConfigureNotify,
+            .display = display,
+            .event = client_window,
+            .window = client_window,
+            .x = geometry->x_root,
+            .y = geometry->y_root + PORTAL_TITLE_BAR_HEIGHT,
+            .width = client_width,
+            .height = client_height,
+            .border_width = 0,
+            .above = None,
+            .override_redirect = False
+        });
     }
 
+    x_end_error_range(display, first_request);
+
     // Call all event handlers of the PortalTransformed event.
     call_event_handlers((Event*)&(PortalTransformedEvent) {
         .type = PortalTransformed,
@@ -337,100 +428,96 @@ void move_portal(Portal *portal, int x_root, int y_root)
     });
 }
 
-void resize_portal(Portal *portal, unsigned int width, unsigned int height)
+static void queue_portal_transform(Portal *portal)
 {
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
-
-    // Ensure the portal has been initialized.
-    if (portal->initialized == false) return;
+    // Remember the geometry as it was before the first queued change.
+    if (!portal->transform_pending)
+    {
+        portal->cold->geometry_committed = portal->geometry;
+        portal->transform_pending = true;
+    }
+}
 
-    // Check if the client window still exists (may have been destroyed).
-    if (!is_portal_client_valid(portal)) return;
+void begin_portal_transaction()
+{
+    transaction_depth++;
+}
 
-    // Resize the portal itself.
-    portal->geometry.width = width;
-    portal->geometry.height = height;
+void commit_portal_transaction()
+{
+    // Ensure this is the outermost transaction.
+    if (transaction_depth == 0) return;
+    transaction_depth--;
+    if (transaction_depth > 0) return;
 
-    // Resize the portal windows.
+    // Apply the queued geometry changes.
+    for (unsigned int i = 0; i < registry.active_count; i++)
     {
-        Window frame_window = portal->frame_window;
-        Window client_window = portal->client_window;
-
-        if (is_portal_frame_valid(portal))
-        {
-            // Resize both the frame and client windows.
-            XResizeWindow(display, frame_window, width, height);
-            XResizeWindow(
-                display,
-                client_window,
-                width,
-                common.int_max(1, height - PORTAL_TITLE_BAR_HEIGHT)
-            );
-        }
-        else
-        {
-            // No frame, just resize the client window.
-            XResizeWindow(display, client_window, width, height);
-        }
+        Portal *portal = registry.active[i];
+        if (!portal->transform_pending) continue;
+        apply_portal_transform(portal);
+    }
+}
 
-        // According to the ICCCM (Sections 4.1.5 and 4.2.3), when a window
-        // manager resizes a reparented client window, it is responsible for
-        // sending a synthetic ConfigureNotify event to the client with the
-        // windows new dimensions and position relative to root.
+void begin_portal_batch()
+{
+    batch_depth++;
+    begin_portal_transaction();
+}
 
-        if (is_portal_frame_valid(portal))
-        {
-            // Retrieve the client window position relative to root.
-            int client_x_root = -1, client_y_root = -1;
-            XTranslateCoordinates(
-                display,            // Display
-                client_window,      // Source window
-                root_window,        // Reference window
-                0, 0,               // Source window origin coordinates
-                &client_x_root,     // Translated X coordinate
-                &client_y_root,     // Translated Y coordinate
-                &(Window){0}        // Child window (Unused)
-            );
-            if (client_x_root == -1 || client_y_root == -1)
-            {
-                // Window was likely destroyed during the operation.
-                return;
-            }
+void end_portal_batch()
+{
+    if (batch_depth == 0) return;
+    commit_portal_transaction();
+    if (--batch_depth > 0) return;
 
-            // Notify the client window of its new geometry.
-            XSendEvent(display, client_window, False, StructureNotifyMask, (XEvent*)&(XConfigureEvent) {
-                .type = ConfigureNotify,
-                .display = display,
-                .event = client_window,
-                .window = client_window,
-                .x = client_x_root,
-                .y = client_y_root,
-                .width = common.int_max(1, width),
-                .height = common.int_max(1, height - PORTAL_TITLE_BAR_HEIGHT),
-                .border_width = 0,
-                .above = None,
-                .override_redirect = False
-            });
-
-            // Process all pending X events.
-            XSync(display, False);
-        }
-    }
+    // Resolve the stacking order once for the whole batch.
+    sort_portals();
 
-    // Call all event handlers of the PortalTransformed event.
-    call_event_handlers((Event*)&(PortalTransformedEvent){
-        .type = PortalTransformed,
-        .portal = portal
+    // Call all event handlers of the PortalBatchEnded event.
+    call_event_handlers((Event*)&(PortalBatchEndedEvent){
+        .type = PortalBatchEnded
     });
 }
 
-void synchronize_portal(Portal *portal)
+bool is_portal_batch_in_progress()
 {
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
-    Window client_window = portal->client_window;
+    return batch_depth > 0;
+}
+
+void move_portal(Portal *portal, int x_root, int y_root)
+{
+    // Ensure the portal has been initialized.
+    if (portal->initialized == false) return;
+
+    // Move the portal itself.
+    queue_portal_transform(portal);
+    portal->geometry.x_root = x_root;
+    portal->geometry.y_root = y_root;
+
+    // Move the portal windows, unless deferred by a transaction.
+    if (transaction_depth == 0) apply_portal_transform(portal);
+}
 
+void resize_portal(Portal *portal, unsigned int width, unsigned int height)
+{
+    // Ensure the portal has been initialized.
+    if (portal->initialized == false) return;
+
+    // Ensure the portal still has a client window.
+    if (portal->client_window == None) return;
+
+    // Resize the portal itself.
+    queue_portal_transform(portal);
+    portal->geometry.width = width;
+    portal->geometry.height = height;
+
+    // Resize the portal windows, unless deferred by a transaction.
+    if (transaction_depth == 0) apply_portal_transform(portal);
+}
+
+void synchronize_portal(Portal *portal, PortalGeometry client_geometry)
+{
     // Ensure the portal has been initialized.
     if (portal->initialized == false) return;
 
@@ -438,75 +525,44 @@ void synchronize_portal(Portal *portal)
     // managed by fullscreen.c and should not be modified.
     if (portal->fullscreen) return;
 
-    // Check if the client window still exists (may have been destroyed).
-    if (!is_portal_client_valid(portal)) return;
-
-    // Retrieve the client window root coordinates.
-    int client_x_root = 0, client_y_root = 0;
-    XTranslateCoordinates(
-        display,                // Display
-        client_window,          // Source window
-        root_window,            // Reference window
-        0, 0,                   // Source window origin coordinates
-        &client_x_root,         // Translated x coordinate
-        &client_y_root,         // Translated y coordinate
-        &(Window){0}            // Child Window (Unused)
-    );
-
-    // Retrieve the client window dimensions.
-    unsigned int client_width = 0, client_height = 0;
-    XGetGeometry(
-        display,                // Display
-        client_window,          // Drawable
-        &(Window){0},           // Root window (Unused)
-        &(int){0},              // X (Relative to parent) (Unused)
-        &(int){0},              // Y (Relative to parent) (Unused)
-        &client_width,          // Width
-        &client_height,         // Height
-        &(unsigned int){0},     // Border width (Unused)
-        &(unsigned int){0}      // Depth (Unused)
-    );
-
     // Calculate the new portal geometry.
-    bool is_framed = is_portal_frame_valid(portal);
-    int portal_x_root = client_x_root;
-    int portal_y_root = client_y_root + (is_framed ? -PORTAL_TITLE_BAR_HEIGHT : 0);
-    unsigned int portal_width = common.int_max(1, client_width);
-    unsigned int portal_height = common.int_max(1, client_height + (is_framed ? PORTAL_TITLE_BAR_HEIGHT : 0));
-
-    // Move the portal if the position has changed and the portal is not framed.
-    // Framed portals have their position controlled by the WM, not the client.
-    if (!is_framed && (portal_x_root != portal->geometry.x_root || portal_y_root != portal->geometry.y_root))
+    bool is_framed = (portal->frame_window != None);
+    int portal_x_root = client_geometry.x_root;
+    int portal_y_root = client_geometry.y_root + (is_framed ? -PORTAL_TITLE_BAR_HEIGHT : 0);
+    unsigned int portal_width = common.int_max(1, client_geometry.width);
+    unsigned int portal_height = common.int_max(1, client_geometry.height + (is_framed ? PORTAL_TITLE_BAR_HEIGHT : 0));
+
+    // Unframed windows are already at the reported geometry, so only the
+    // stored geometry has to follow, without issuing any requests.
+    if (!is_framed)
     {
-        move_portal(portal, portal_x_root, portal_y_root);
+        if (portal_x_root == portal->geometry.x_root &&
+            portal_y_root == portal->geometry.y_root &&
+            portal_width == portal->geometry.width &&
+            portal_height == portal->geometry.height)
+        {
+            return;
+        }
+        portal->geometry = (PortalGeometry){
+            portal_x_root, portal_y_root,
+            portal_width, portal_height
+        };
+        portal->cold->geometry_committed = portal->geometry;
+
+        // Call all event handlers of the PortalTransformed event.
+        call_event_handlers((Event*)&(PortalTransformedEvent){
+            .type = PortalTransformed,
+            .portal = portal
+        });
+        return;
     }
 
-    // Resize the portal, only if the dimensions have changed.
+    // Resize the portal, only if the dimensions have changed. Framed portals
+    // have their position controlled by the WM, not the client.
     if (portal_width != portal->geometry.width || portal_height != portal->geometry.height)
     {
         resize_portal(portal, portal_width, portal_height);
     }
-
-    // Synchronize all child portals as well.
-    Window *child_windows = NULL;
-    unsigned int child_window_count = 0;
-    XQueryTree(
-        display,            // Display
-        client_window,      // Window
-        &(Window){0},       // Root window (Unused)
-        &(Window){0},       // Parent window (Unused)
-        &child_windows,     // Children
-        &child_window_count // Children count
-    );
-    for (int i = 0; i < (int)child_window_count; i++)
-    {
-        Portal *child_portal = find_portal_by_window(child_windows[i]);
-        if (child_portal != NULL)
-        {
-            synchronize_portal(child_portal);
-        }
-    }
-    XFree(child_windows);
 }
 
 Portal *get_top_portal()
@@ -528,10 +584,9 @@ void raise_portal(Portal *portal)
     // Raise all transient children whose root matches, so they stack
     // above the parent. This naturally handles chains since each child
     // is raised after its ancestor.
-    for (int i = 0; i < MAX_PORTALS; i++)
+    for (unsigned int i = 0; i < registry.active_count; i++)
     {
-        Portal *candidate = &registry.unsorted[i];
-        if (!candidate->active) continue;
+        Portal *candidate = registry.active[i];
         if (!candidate->initialized) continue;
         if (candidate->transient_for == NULL) continue;
         if (find_portal_transient_root(candidate) == root)
@@ -597,9 +652,10 @@ void map_portal(Portal *portal)
     if (!portal->override_redirect && first_map)
     {
         bool should_center = true;
-        XSizeHints hints;
-        if (XGetWMNormalHints(display, portal->client_window, &hints, &(long){0}))
+        if (portal->cold->properties.has_normal_hints)
         {
+            XSizeHints hints = portal->cold->properties.normal_hints;
+
             // Check if position hints represent an intentional placement.
             // Positions at or near origin (0,0 or 1,1) are often toolkit
             // defaults.
@@ -643,14 +699,11 @@ void map_portal(Portal *portal)
         }
     }
 
-    // Synchronize the portal geometry.
-    synchronize_portal(portal);
-
     // Seed `geometry_floating_backup` on first map so portals spawned into
     // tiling mode have a fallback size for tiling -> floating transitions.
-    if (first_map && portal->geometry_floating_backup.width == 0)
+    if (first_map && portal->cold->geometry_floating_backup.width == 0)
     {
-        portal->geometry_floating_backup = portal->geometry;
+        portal->cold->geometry_floating_backup = portal->geometry;
     }
 
     // Raise the portal above its parent if applicable, as per ICCCM.
@@ -676,6 +729,9 @@ void unmap_portal(Portal *portal)
 {
     Display *display = DefaultDisplay;
 
+    // Unpark the portal, so it receives input again once remapped.
+    unpark_portal(portal);
+
     // Unmap non-override-redirect portals. Override-redirect clients manage
     // themselves, but we still transition them to hidden later.
     if (!portal->override_redirect)
@@ -712,9 +768,9 @@ void suspend_portal(Portal *portal)
 
     bool visible_before_suspend = (portal->visibility == PORTAL_VISIBLE);
 
-    // Unmap the outermost window of non-override-redirect portals
+    // Park or unmap the outermost window of non-override-redirect portals
     // that are currently visible.
-    if (visible_before_suspend && !portal->override_redirect)
+    if (visible_before_suspend && !portal->override_redirect && park_portal(portal) != 0)
     {
         if (is_portal_frame_valid(portal))
         {
@@ -745,71 +801,65 @@ void reveal_portal(Portal *portal)
     // Only reveal portals that are suspended.
     if (portal->visibility != PORTAL_SUSPENDED) return;
 
+    // Unpark the portal, its windows are still mapped.
+    unpark_portal(portal);
+
     // Map the portal (transitions to PORTAL_VISIBLE).
     map_portal(portal);
 }
 
-int get_portal_index(Portal *portal)
-{
-    for (int i = 0; i < MAX_PORTALS; i++)
-    {
-        if (&registry.unsorted[i] == portal && registry.unsorted[i].active)
-        {
-            return i;
-        }
-    }
-    return -1;
-}
-
-Portal *get_unsorted_portals()
+Portal **get_active_portals(unsigned int *out_count)
 {
-    return registry.unsorted;
+    *out_count = registry.active_count;
+    return registry.active;
 }
 
 Portal **get_sorted_portals(unsigned int *out_count)
 {
-    *out_count = registry.active_count;
+    *out_count = registry.sorted_count;
     return registry.sorted;
 }
 
 void sort_portals()
 {
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
+    // Defer sorting until the batch in progress ends, which sorts once.
+    if (batch_depth > 0) return;
 
-    // Retrieve all windows in stacking order.
-    Window *windows = NULL;
-    unsigned int window_count = 0;
-    int status = x_query_tree_recursively(
-        display,        // Display
-        root_window,    // Parent
-        &windows,       // Children
-        &window_count   // Children count
-    );
-    if (status != 0)
+    // Synchronize the mirrored stacking order first, if it could have
+    // diverged from the actual stacking order.
+    if (is_window_stack_uncertain())
     {
-        LOG_ERROR("Could not sort portals, tree query failed (%d).", status);
-        free(windows);
-        return;
+        int status = synchronize_window_stack();
+        if (status != 0)
+        {
+            LOG_ERROR("Could not sort portals, stack synchronization failed (%d).", status);
+        }
     }
 
+    // Retrieve the root window children in stacking order.
+    unsigned int window_count = 0;
+    const Window *windows = get_stacked_windows(&window_count);
+
     // Build sorted portals array from windows array.
     int portals_added = 0;
-    for (int i = 0; i < (int)window_count; i++)
+    for (unsigned int i = 0; i < window_count && portals_added < (int)registry.capacity; i++)
     {
         // Ensure the window belongs to a portal.
-        Portal *portal = find_portal_by_window(windows[i]);
+        PortalWindowRole role;
+        Portal *portal = lookup_portal_window(windows[i], &role);
         if (portal == NULL) continue;
         if (!portal->active) continue;
 
-        // Ensure we only handle client windows, and not frame windows as well,
-        // preventing duplicate entries in the sorted portals array.
-        if (windows[i] != portal->client_window) continue;
+        // Framed portals are stacked by their frame window, and unframed
+        // portals by their client window, preventing duplicate entries in
+        // the sorted portals array.
+        if (role == PORTAL_WINDOW_CLIENT && portal->frame_window != None) continue;
 
         // Add portal to the sorted array.
         registry.sorted[portals_added] = portal;
         portals_added++;
     }
+    registry.sorted_count = portals_added;
 
     // Synchronize top_portal to the topmost visible portal.
     top_portal = NULL;
@@ -821,34 +871,14 @@ void sort_portals()
             break;
         }
     }
-
-    // Clear remaining slots, if any.
-    while (portals_added < MAX_PORTALS) {
-        registry.sorted[portals_added] = NULL;
-        portals_added++;
-    }
-
-    // Cleanup.
-    free(windows);
 }
 
 Portal *find_portal_by_window(Window window)
 {
-    // Iterate over the unsorted portals to find the portal associated with
-    // the specified window.
-    for (int i = 0; i < MAX_PORTALS; i++)
-    {
-        Portal *portal = &registry.unsorted[i];
-        if (!portal->active) continue;
-
-        // Check if the portal is associated with the specified window.
-        if (portal->frame_window == window ||
-            portal->client_window == window)
-        {
-            return portal;
-        }
-    }
-    return NULL;
+    // Look up the portal associated with the specified window in the index.
+    Portal *portal = lookup_portal_window(window, NULL);
+    if (portal == NULL || !portal->active) return NULL;
+    return portal;
 }
 
 Portal *find_or_create_portal(Window window)
@@ -856,22 +886,24 @@ Portal *find_or_create_portal(Window window)
     Portal *portal = find_portal_by_window(window);
     if (portal != NULL) return portal;
 
-    Display *display = DefaultDisplay;
-    Window root_window = DefaultRootWindow(display);
-
-    pid_t pid = x_get_window_pid(display, window);
-    if (pid == getpid()) return NULL;
+    // Fetch the window properties in a single batch, to determine whether
+    // the window should become a portal.
+    PortalProperties properties;
+    if (fetch_portal_properties(window, &properties) != 0) return NULL;
+    if (properties.pid == getpid()) return NULL;
+    if (properties.parent != DefaultRootWindow(DefaultDisplay)) return NULL;
 
-    if (x_get_window_parent(display, window) != root_window) return NULL;
-
-    return create_portal(window);
+    // Create the portal, handing it the fetched properties.
+    portal = create_portal(window);
+    if (portal != NULL) portal->cold->properties = properties;
+    return portal;
 }
 
 Portal *find_portal_at_pos(int x_root, int y_root)
 {
     // Iterate over the sorted portals in reverse order, to find the topmost
     // portal at the specified position.
-    for (int i = MAX_PORTALS - 1; i >= 0; i--)
+    for (int i = (int)registry.sorted_count - 1; i >= 0; i--)
     {
         Portal *portal = registry.sorted[i];
 
@@ -897,7 +929,7 @@ Portal *find_portal_transient_root(Portal *portal)
 {
     // Walk up the transient chain to the root.
     int depth = 0;
-    while (portal->transient_for != NULL && depth < MAX_PORTALS)
+    while (portal->transient_for != NULL && depth < (int)registry.active_count)
     {
         portal = portal->transient_for;
         depth++;
@@ -910,48 +942,96 @@ void populate_portal_transient_for(Portal *portal)
     // Skip if the transient relationship is already resolved.
     if (portal->transient_for != NULL) return;
 
-    // Query the `WM_TRANSIENT_FOR` property and look up the parent portal.
-    Window transient_parent = None;
-    if (x_get_transient_for(DefaultDisplay, portal->client_window, &transient_parent) == 0)
+    // Look up the parent portal from the `WM_TRANSIENT_FOR` property.
+    populate_portal_properties(portal);
+    if (portal->cold->properties.transient_for != None)
     {
-        portal->transient_for = find_portal_by_window(transient_parent);
+        portal->transient_for = find_portal_by_window(portal->cold->properties.transient_for);
     }
 }
 
+int populate_portal_properties(Portal *portal)
+{
+    // Skip if the properties were already fetched.
+    if (portal->cold->properties.fetched) return 0;
+
+    // Fetch the client window state and properties in a single batch.
+    return fetch_portal_properties(portal->client_window, &portal->cold->properties);
+}
+
+bool is_adopting_portal_windows()
+{
+    return adopting;
+}
+
 void adopt_existing_portal_windows()
 {
     Display *display = DefaultDisplay;
     Window root_window = DefaultRootWindow(display);
+    TimelineSpan span = begin_timeline_span("portals", "adopt_existing_portal_windows");
+    uint64_t start_us = get_monotonic_time_us();
+
+    // Load the session state left behind by a previous instance, if any.
+    load_session_state();
 
     // Grab the server to prevent events while scanning.
     XGrabServer(display);
+    TimelineSpan grab_span = begin_timeline_span("portals", "server_grab");
 
     // Query all children of the root window (bottom-to-top stacking order).
     Window *children = NULL;
     unsigned int child_count = 0;
-    XQueryTree(display, root_window, &(Window){0}, &(Window){0}, &children, &child_count);
+    X_ROUND_TRIP(XQueryTree, display, root_window, &(Window){0}, &(Window){0}, &children, &child_count);
 
+    // Mirror the stacking order of the root window children, from here on
+    // it is maintained incrementally.
+    if (set_window_stack(children, child_count) != 0)
+    {
+        LOG_ERROR("Could not mirror the stacking order, memory allocation failed.");
+    }
+
+    // Request the properties of all children up front, so their replies
+    // arrive within a single round trip rather than one per child.
+    PortalPropertiesRequest *requests = malloc(child_count * sizeof(PortalPropertiesRequest));
+    if (requests == NULL && child_count > 0)
+    {
+        LOG_ERROR("Could not adopt existing windows, memory allocation failed.");
+        XFree(children);
+        XUngrabServer(display);
+        end_timeline_span(&grab_span);
+        end_timeline_span(&span);
+        return;
+    }
     for (unsigned int i = 0; i < child_count; i++)
     {
-        // Skip windows that are override-redirect or not visible.
-        XWindowAttributes attrs;
-        if (!XGetWindowAttributes(display, children[i], &attrs)) continue;
-        if (attrs.override_redirect) continue;
-        if (attrs.map_state != IsViewable) continue;
+        requests[i] = request_portal_properties(children[i]);
+    }
+
+    // Adopt all portals in a single batch, deferring sorting, focus and
+    // client list updates until all of them are adopted.
+    adopting = true;
+    begin_portal_batch();
+    unsigned int adopted_count = 0;
+    for (unsigned int i = 0; i < child_count; i++)
+    {
+        // Skip windows that are gone, override-redirect or not visible.
+        PortalProperties properties;
+        if (collect_portal_properties(&requests[i], &properties) != 0) continue;
+        if (properties.override_redirect) continue;
+        if (!properties.viewable) continue;
 
         // Skip windows owned by this WM process.
-        pid_t pid = x_get_window_pid(display, children[i]);
-        if (pid == getpid()) continue;
+        if (properties.pid == getpid()) continue;
 
-        // Create a portal for this window.
+        // Create a portal for this window, handing it the fetched properties.
         Portal *portal = create_portal(children[i]);
         if (portal == NULL) continue;
+        portal->cold->properties = properties;
 
-        // Read `_NET_WM_DESKTOP` to restore the workspace assignment.
-        int desktop = x_get_window_desktop(display, children[i]);
-        if (desktop >= 0 && desktop < MAX_WORKSPACES)
+        // Restore the workspace assignment from `_NET_WM_DESKTOP`.
+        if (properties.desktop >= 0 && properties.desktop < MAX_WORKSPACES)
         {
-            portal->workspace = desktop;
+            portal->workspace = properties.desktop;
         }
 
         // Initialize the portal (captures geometry, creates frame, fires events).
@@ -968,15 +1048,37 @@ void adopt_existing_portal_windows()
         {
             suspend_portal(portal);
         }
+        adopted_count++;
     }
+    end_portal_batch();
+    adopting = false;
 
+    free(requests);
     XFree(children);
 
     // Ungrab the server so events can be processed again.
     XUngrabServer(display);
+    end_timeline_span(&grab_span);
 
-    // Synchronize stacking order once after all portals are adopted.
-    sort_portals();
+    // Call all event handlers of the PortalsAdopted event.
+    call_event_handlers((Event*)&(PortalsAdoptedEvent){
+        .type = PortalsAdopted,
+        .adopted_count = adopted_count
+    });
+
+    // Remember the outcome for the profile report.
+    adoption_count = adopted_count;
+    adoption_duration_us = get_monotonic_time_us() - start_us;
+
+    end_timeline_span(&span);
+}
+
+void report_portal_adoption()
+{
+    fprintf(stderr,
+        "Adopted %u existing windows at startup in %.3f ms.\n",
+        adoption_count, adoption_duration_us / 1000.0
+    );
 }
 
 PortalDecoration get_portal_decoration_kind(Portal *portal)
@@ -988,19 +1090,8 @@ PortalDecoration get_portal_decoration_kind(Portal *portal)
     }
 
     // Skip tooltips and notifications (not managed as separate portals).
-    Display *display = DefaultDisplay;
-    static Atom tooltip = None;
-    if (tooltip == None)
-    {
-        tooltip = XInternAtom(display, "_NET_WM_WINDOW_TYPE_TOOLTIP", False);
-    }
-    static Atom notification = None;
-    if (notification == None)
-    {
-        notification = XInternAtom(display, "_NET_WM_WINDOW_TYPE_NOTIFICATION", False);
-    }
-    if (portal->client_window_type == tooltip ||
-        portal->client_window_type == notification
+    if (portal->client_window_type == ATOM(_NET_WM_WINDOW_TYPE_TOOLTIP) ||
+        portal->client_window_type == ATOM(_NET_WM_WINDOW_TYPE_NOTIFICATION)
     ) {
         return PORTAL_DECORATION_NONE;
     }
@@ -10,9 +10,6 @@
 /** The minimum height of a portal in pixels. */
 #define MINIMUM_PORTAL_HEIGHT 64
 
-/** The maximum number of portals that can be managed simultaneously. */
-#define MAX_PORTALS 256
-
 /** A type representing the decoration style applied to a portal. */
 typedef enum
 {
@@ -41,31 +38,53 @@ typedef struct {
     unsigned int width, height;
 } PortalGeometry;
 
+/**
+ * The rarely accessed state of a portal, kept apart from the portal itself so
+ * scans over portals only touch the frequently accessed state.
+ */
+typedef struct {
+    char *title;
+    PortalGeometry geometry_fullscreen_backup; // Saved for fullscreen restore.
+    PortalGeometry geometry_floating_backup;   // Saved for floating restore.
+    PortalGeometry geometry_committed;         // Applied before the pending change.
+    unsigned long configure_serial;  // Serial of the last configure request.
+    cairo_t *frame_cr;
+    Visual *frame_visual;
+    Visual *client_visual;
+    PortalProperties properties;     // Cached client window properties.
+    unsigned long parked_sequence;   // When parked, relative to other portals.
+    Window redirected_client;        // Client redirected for split rendering.
+} PortalColdState;
+
 /**
  * A portal represents a window pair consisting of a decorative frame and the
  * client content area, along with its geometry and rendering state.
+ *
+ * Only the frequently accessed state is stored inline, the rest is stored in
+ * `cold`, which is owned by the portal pool.
  */
 typedef struct Portal {
     bool active;                     // Whether this registry slot is in use.
-    char *title;
     bool initialized;                // Whether first-time setup has completed.
     bool top_level;                  // Whether this portal is a child of root.
-    struct Portal *transient_for;    // Parent portal if transient, else NULL.
-    PortalVisibility visibility;     // Lifecycle visibility state.
-    ThemeVariant theme;              // Resolved light or dark theme variant.
     bool override_redirect;          // Whether client manages its own geometry.
     bool fullscreen;
+    bool transform_pending;          // Whether geometry awaits being applied.
+    bool frame_alive;                // Whether the frame window still exists.
+    bool client_alive;               // Whether the client window still exists.
+    bool misaligned;                 // Whether client moved within frame.
+    bool surface_failed;             // Whether its last pixmap was invalid.
+    bool parked;                     // Whether suspended but kept mapped.
+    PortalVisibility visibility;     // Lifecycle visibility state.
+    ThemeVariant theme;              // Resolved light or dark theme variant.
     int workspace;                   // -1 if unassigned.
     PortalGeometry geometry;
-    PortalGeometry geometry_fullscreen_backup; // Saved for fullscreen restore.
-    PortalGeometry geometry_floating_backup;   // Saved for floating restore.
+    struct Portal *transient_for;    // Parent portal if transient, else NULL.
     Window frame_window;
-    cairo_t *frame_cr;
-    Visual *frame_visual;
     Window client_window;
+    Window client_parent;            // Parent of the client, as last reported.
     Atom client_window_type;         // The _NET_WM_WINDOW_TYPE of the client.
-    Visual *client_visual;
-    bool misaligned;                 // Whether client moved within frame.
+    PortalColdState *cold;           // Rarely accessed state.
 } Portal;
 
 /**
@@ -75,6 +94,8 @@ typedef struct Portal {
  * 
  * @return - `Portal*` The portal was created successfully.
  * @return - `NULL` The portal could not be created.
+ *
+ * @note The client window must be a direct child of root.
  */
 Portal *create_portal(Window client_window);
 
@@ -88,12 +109,57 @@ Portal *create_portal(Window client_window);
  */
 void destroy_portal(Portal *portal);
 
+/**
+ * Begins a geometry transaction, deferring the window requests of
+ * `move_portal()` and `resize_portal()` until the matching
+ * `commit_portal_transaction()` call.
+ *
+ * @note Transactions can be nested, only the outermost commit applies the
+ * queued changes.
+ */
+void begin_portal_transaction();
+
+/**
+ * Commits a geometry transaction, applying the queued geometry changes of
+ * each portal with a single configure request per window and a single
+ * synthetic `ConfigureNotify` event. Portals whose geometry ended up
+ * unchanged are skipped entirely.
+ */
+void commit_portal_transaction();
+
+/**
+ * Begins a batch of portal operations, such as mapping and suspending many
+ * portals at once. A batch is a geometry transaction that additionally
+ * defers stacking resolution and the per-portal focus and client list
+ * updates until the matching `end_portal_batch()` call.
+ *
+ * @note Batches can be nested, only the outermost end completes them.
+ */
+void begin_portal_batch();
+
+/**
+ * Ends a batch of portal operations, committing its geometry transaction,
+ * sorting the portals once and firing `PortalBatchEnded`.
+ */
+void end_portal_batch();
+
+/**
+ * Checks whether a batch of portal operations is in progress.
+ *
+ * @return - `true` A batch is in progress, per-portal work that is redone
+ * once when it ends can be skipped.
+ * @return - `false` No batch is in progress.
+ */
+bool is_portal_batch_in_progress();
+
 /**
  * Moves a portal to a new position.
  *
  * @param portal The portal to move.
  * @param x_root The new X coordinate relative to root.
  * @param y_root The new Y coordinate relative to root.
+ *
+ * @note Deferred until the transaction is committed, if one is in progress.
  */
 void move_portal(Portal *portal, int x_root, int y_root);
 
@@ -103,15 +169,19 @@ void move_portal(Portal *portal, int x_root, int y_root);
  * @param portal The portal to resize.
  * @param width The new width in pixels.
  * @param height The new height in pixels.
+ *
+ * @note Deferred until the transaction is committed, if one is in progress.
  */
 void resize_portal(Portal *portal, unsigned int width, unsigned int height);
 
 /**
- * Synchronizes the portal's stored geometry with its actual window geometry.
+ * Synchronizes the portal's stored geometry with the client window geometry
+ * reported by the X server.
  *
  * @param portal The portal to synchronize.
+ * @param client_geometry The client window geometry, relative to root.
  */
-void synchronize_portal(Portal *portal);
+void synchronize_portal(Portal *portal, PortalGeometry client_geometry);
 
 /**
  * Returns the top portal in the stacking order.
@@ -170,35 +240,29 @@ void suspend_portal(Portal *portal);
 void reveal_portal(Portal *portal);
 
 /**
- * Retrieves the index of a portal in the unsorted registry array.
- *
- * @param portal The portal to find.
+ * Retrieves the array of active portal pointers from the registry.
  *
- * @return - `>= 0` The index of the portal in the registry.
- * @return - `-1` The portal was not found.
- */
-int get_portal_index(Portal *portal);
-
-/**
- * Retrieves the unsorted array of portals from the registry.
+ * Returns a packed array of pointers to active portals only, in creation
+ * order, so no active checks are needed. The array may be reallocated when
+ * a portal is created, so callers must not hold on to it across calls that
+ * may create portals.
  *
- * Returns a fixed-size array with inactive slots scattered throughout
- * (tombstone pattern). Caller must iterate up to MAX_PORTALS and skip
- * entries where portal->active is false.
+ * @param out_count Pointer to store the number of active portals.
  *
- * @return The unsorted portal array (Portal[MAX_PORTALS]).
+ * @return The active portal pointer array.
  */
-Portal *get_unsorted_portals();
+Portal **get_active_portals(unsigned int *out_count);
 
 /**
  * Retrieves the sorted array of portal pointers from the registry.
  *
- * Unlike get_unsorted_portals(), this returns a packed array of pointers
+ * Like get_active_portals(), this returns a packed array of pointers
  * to active portals only, sorted by stacking order (bottom to top).
  * The array is rebuilt on each stacking change, so no active checks needed.
- * Entries beyond out_count may be NULL.
+ * Entries beyond out_count are undefined. Portals whose windows are not
+ * children of root (e.g., embedded by another client) are not included.
  *
- * @param out_count Pointer to store the number of active portals.
+ * @param out_count Pointer to store the number of sorted portals.
  *
  * @return The sorted portal pointer array.
  */
@@ -206,6 +270,9 @@ Portal **get_sorted_portals(unsigned int *out_count);
 
 /**
  * Sorts portals in the registry based on their stacking order.
+ *
+ * @note The stacking order is mirrored incrementally (see `stacking.h`), so
+ * this only queries the X server if the mirrored order became uncertain.
  */
 void sort_portals();
 
@@ -262,13 +329,48 @@ Portal *find_portal_transient_root(Portal *portal);
  */
 void populate_portal_transient_for(Portal *portal);
 
+/**
+ * Fetches the client window state and properties of a portal in a single
+ * batch, caching them on the portal.
+ *
+ * @param portal The portal to fetch the properties of.
+ *
+ * @return - `0` The properties are available.
+ * @return - `-1` The client window does not exist (anymore).
+ *
+ * @note Has no effect if the properties were already fetched, they are kept
+ * current by property change events from then on.
+ */
+int populate_portal_properties(Portal *portal);
+
 /**
  * Scans the X server for existing top-level windows and adopts them
  * as portals. Called once at startup to re-manage windows from a
  * previous WM session.
+ *
+ * @note The properties of all windows are fetched in a single round trip,
+ * and all windows are adopted in a single batch, after which
+ * `PortalsAdopted` is fired.
  */
 void adopt_existing_portal_windows();
 
+/**
+ * Prints the number of windows adopted at startup, and the time it took, to
+ * `stderr`.
+ *
+ * @note The report is printed alongside the event handler profile, at exit
+ * and when the window manager receives `SIGUSR1`.
+ */
+void report_portal_adoption();
+
+/**
+ * Checks whether existing windows are being adopted.
+ *
+ * @return - `true` Existing windows are being adopted.
+ * @return - `false` No adoption is in progress.
+ */
+bool is_adopting_portal_windows();
+
 /**
  * Determines the decoration kind for a portal.
  *
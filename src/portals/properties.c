@@ -0,0 +1,391 @@
+/**
+ * This code is responsible for fetching the client window state and
+ * properties of portals. All requests for a window are issued at once
+ * through the XCB connection underlying Xlib, and their replies are collected
+ * afterwards, so fetching costs a single round trip rather than one per
+ * property.
+ */
+
+#include "../all.h"
+
+/** The number of 32-bit items in a full `WM_SIZE_HINTS` property (ICCCM). */
+#define SIZE_HINTS_ITEM_COUNT 18
+
+/** The number of 32-bit items in a pre-ICCCM `WM_SIZE_HINTS` property. */
+#define SIZE_HINTS_OLD_ITEM_COUNT 15
+
+/** The sequence number of the last request issued for properties. */
+static unsigned int last_requested_sequence = 0;
+
+/**
+ * The sequence number of the last request issued before the last wait for
+ * replies, whose replies are on their way without another round trip.
+ */
+static unsigned int waited_through_sequence = 0;
+
+static xcb_get_property_cookie_t request_property(
+    xcb_connection_t *connection,
+    Window window,
+    Atom property,
+    Atom type,
+    uint32_t length
+)
+{
+    return xcb_get_property(connection, 0, window, property, type, 0, length);
+}
+
+static xcb_get_property_reply_t *collect_property(
+    xcb_connection_t *connection,
+    xcb_get_property_cookie_t cookie
+)
+{
+    // Collect the reply, discarding errors for properties of vanished windows.
+    xcb_generic_error_t *error = NULL;
+    xcb_get_property_reply_t *reply = xcb_get_property_reply(connection, cookie, &error);
+    free(error);
+
+    // Treat properties that don't exist as missing replies.
+    if (reply != NULL && reply->type == XCB_NONE)
+    {
+        free(reply);
+        return NULL;
+    }
+    return reply;
+}
+
+static uint32_t *get_property_items(xcb_get_property_reply_t *reply, int *out_count)
+{
+    // Ensure the property consists of 32-bit items.
+    if (reply == NULL || reply->format != 32)
+    {
+        *out_count = 0;
+        return NULL;
+    }
+    *out_count = xcb_get_property_value_length(reply) / 4;
+    return (uint32_t *)xcb_get_property_value(reply);
+}
+
+static void copy_property_string(xcb_get_property_reply_t *reply, int offset, char *out_buffer, size_t buffer_size)
+{
+    const char *value = (const char *)xcb_get_property_value(reply);
+    int length = xcb_get_property_value_length(reply) - offset;
+    if (length < 0) length = 0;
+    if ((size_t)length > buffer_size - 1) length = buffer_size - 1;
+    memcpy(out_buffer, value + offset, length);
+    out_buffer[length] = '\0';
+}
+
+static Visual *find_visual(Display *display, xcb_visualid_t visual_id)
+{
+    // Look the visual up in the screen information Xlib received on connect.
+    Screen *screen = DefaultScreenOfDisplay(display);
+    for (int i = 0; i < screen->ndepths; i++)
+    {
+        Depth *depth = &screen->depths[i];
+        for (int j = 0; j < depth->nvisuals; j++)
+        {
+            if (depth->visuals[j].visualid == visual_id) return &depth->visuals[j];
+        }
+    }
+    return NULL;
+}
+
+static void parse_normal_hints(xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    properties->has_normal_hints = false;
+    int count = 0;
+    uint32_t *items = get_property_items(reply, &count);
+    if (count < SIZE_HINTS_OLD_ITEM_COUNT) return;
+
+    // Convert the property to Xlib's representation, as `XGetWMNormalHints()`
+    // would, dropping the ICCCM additions if the property predates them.
+    XSizeHints *hints = &properties->normal_hints;
+    hints->flags = items[0];
+    hints->x = (int32_t)items[1];
+    hints->y = (int32_t)items[2];
+    hints->width = (int32_t)items[3];
+    hints->height = (int32_t)items[4];
+    hints->min_width = (int32_t)items[5];
+    hints->min_height = (int32_t)items[6];
+    hints->max_width = (int32_t)items[7];
+    hints->max_height = (int32_t)items[8];
+    hints->width_inc = (int32_t)items[9];
+    hints->height_inc = (int32_t)items[10];
+    hints->min_aspect.x = (int32_t)items[11];
+    hints->min_aspect.y = (int32_t)items[12];
+    hints->max_aspect.x = (int32_t)items[13];
+    hints->max_aspect.y = (int32_t)items[14];
+    if (count >= SIZE_HINTS_ITEM_COUNT)
+    {
+        hints->base_width = (int32_t)items[15];
+        hints->base_height = (int32_t)items[16];
+        hints->win_gravity = (int32_t)items[17];
+    }
+    else
+    {
+        hints->flags &= ~(PBaseSize | PWinGravity);
+    }
+    properties->has_normal_hints = true;
+}
+
+static void parse_wm_class(xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    // Extract the `res_class` part of `WM_CLASS`, following `res_name`.
+    properties->wm_class[0] = '\0';
+    if (reply == NULL) return;
+    const char *value = (const char *)xcb_get_property_value(reply);
+    int length = xcb_get_property_value_length(reply);
+    const char *separator = memchr(value, '\0', length);
+    if (separator == NULL) return;
+    copy_property_string(reply, (int)(separator - value) + 1, properties->wm_class, sizeof(properties->wm_class));
+}
+
+static void parse_window_type(xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    int count = 0;
+    uint32_t *window_types = get_property_items(reply, &count);
+    properties->window_type = (count > 0) ? window_types[0] : ATOM(_NET_WM_WINDOW_TYPE_NORMAL);
+}
+
+static void parse_motif_hints(xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    // The Motif hints request no decorations if the decorations flag
+    // (`MWM_HINTS_DECORATIONS = (1 << 1)`) is set with a value of zero.
+    int count = 0;
+    uint32_t *hints = get_property_items(reply, &count);
+    properties->wants_decorations = !(count >= 3 && (hints[0] & (1 << 1)) && hints[2] == 0);
+}
+
+static void parse_transient_for(xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    int count = 0;
+    uint32_t *transient_windows = get_property_items(reply, &count);
+    properties->transient_for = (count > 0) ? transient_windows[0] : None;
+}
+
+/**
+ * Requests one of the properties that are kept current after the initial
+ * fetch, see `HANDLE(PropertyNotify)`.
+ */
+static xcb_get_property_cookie_t request_tracked_property(
+    xcb_connection_t *connection,
+    Window window,
+    Atom property
+)
+{
+    uint32_t string_length = PORTAL_PROPERTY_STRING_LENGTH / 4;
+    if (property == XA_WM_CLASS)
+    {
+        return request_property(connection, window, XA_WM_CLASS, XA_STRING, string_length * 2);
+    }
+    if (property == XA_WM_TRANSIENT_FOR)
+    {
+        return request_property(connection, window, XA_WM_TRANSIENT_FOR, XA_WINDOW, 1);
+    }
+    if (property == XA_WM_NORMAL_HINTS)
+    {
+        return request_property(connection, window, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, SIZE_HINTS_ITEM_COUNT);
+    }
+    if (property == ATOM(_MOTIF_WM_HINTS))
+    {
+        return request_property(connection, window, property, XCB_GET_PROPERTY_TYPE_ANY, 5);
+    }
+    return request_property(connection, window, property, XA_ATOM, 1);
+}
+
+/**
+ * Parses one of the properties requested by `request_tracked_property()`
+ * into the matching fields of the properties.
+ */
+static void parse_tracked_property(Atom property, xcb_get_property_reply_t *reply, PortalProperties *properties)
+{
+    if (property == XA_WM_CLASS) parse_wm_class(reply, properties);
+    else if (property == XA_WM_TRANSIENT_FOR) parse_transient_for(reply, properties);
+    else if (property == XA_WM_NORMAL_HINTS) parse_normal_hints(reply, properties);
+    else if (property == ATOM(_MOTIF_WM_HINTS)) parse_motif_hints(reply, properties);
+    else parse_window_type(reply, properties);
+}
+
+PortalPropertiesRequest request_portal_properties(Window window)
+{
+    xcb_connection_t *connection = XGetXCBConnection(DefaultDisplay);
+    uint32_t string_length = PORTAL_PROPERTY_STRING_LENGTH / 4;
+
+    PortalPropertiesRequest request = {
+        .window = window,
+        .attributes = xcb_get_window_attributes(connection, window),
+        .geometry = xcb_get_geometry(connection, window),
+        .tree = xcb_query_tree(connection, window),
+        .net_wm_name = request_property(connection, window, ATOM(_NET_WM_NAME), XCB_GET_PROPERTY_TYPE_ANY, string_length),
+        .wm_name = request_property(connection, window, XA_WM_NAME, XCB_GET_PROPERTY_TYPE_ANY, string_length),
+        .wm_class = request_tracked_property(connection, window, XA_WM_CLASS),
+        .window_type = request_tracked_property(connection, window, ATOM(_NET_WM_WINDOW_TYPE)),
+        .motif_hints = request_tracked_property(connection, window, ATOM(_MOTIF_WM_HINTS)),
+        .transient_for = request_tracked_property(connection, window, XA_WM_TRANSIENT_FOR),
+        .normal_hints = request_tracked_property(connection, window, XA_WM_NORMAL_HINTS),
+        .pid = request_property(connection, window, ATOM(_NET_WM_PID), XA_CARDINAL, 1),
+        .desktop = request_property(connection, window, ATOM(_NET_WM_DESKTOP), XA_CARDINAL, 1)
+    };
+    last_requested_sequence = request.desktop.sequence;
+    return request;
+}
+
+static int collect_portal_replies(PortalPropertiesRequest *request, PortalProperties *out_properties)
+{
+    Display *display = DefaultDisplay;
+    xcb_connection_t *connection = XGetXCBConnection(display);
+    TimelineSpan span = begin_timeline_span("x11", "collect_portal_properties");
+
+    // Start from the defaults used for missing properties.
+    PortalProperties *properties = out_properties;
+    *properties = (PortalProperties){
+        .fetched = true,
+        .window_class = InputOutput,
+        .parent = None,
+        .window_type = ATOM(_NET_WM_WINDOW_TYPE_NORMAL),
+        .wants_decorations = true,
+        .transient_for = None,
+        .pid = -1,
+        .desktop = -1
+    };
+    strcpy(properties->title, "Untitled");
+
+    // Collect the window attributes.
+    xcb_generic_error_t *error = NULL;
+    xcb_get_window_attributes_reply_t *attributes = xcb_get_window_attributes_reply(connection, request->attributes, &error);
+    free(error);
+    if (attributes != NULL)
+    {
+        properties->viewable = (attributes->map_state == XCB_MAP_STATE_VIEWABLE);
+        properties->override_redirect = attributes->override_redirect;
+        properties->window_class = attributes->_class;
+        properties->visual = find_visual(display, attributes->visual);
+        free(attributes);
+    }
+
+    // Collect the window geometry.
+    error = NULL;
+    xcb_get_geometry_reply_t *geometry = xcb_get_geometry_reply(connection, request->geometry, &error);
+    free(error);
+    if (geometry != NULL)
+    {
+        properties->x = geometry->x;
+        properties->y = geometry->y;
+        properties->width = geometry->width;
+        properties->height = geometry->height;
+        free(geometry);
+    }
+
+    // Collect the parent window.
+    error = NULL;
+    xcb_query_tree_reply_t *tree = xcb_query_tree_reply(connection, request->tree, &error);
+    free(error);
+    if (tree != NULL)
+    {
+        properties->parent = tree->parent;
+        free(tree);
+    }
+
+    // Collect the title, preferring `_NET_WM_NAME` over `WM_NAME`.
+    xcb_get_property_reply_t *net_wm_name = collect_property(connection, request->net_wm_name);
+    xcb_get_property_reply_t *wm_name = collect_property(connection, request->wm_name);
+    xcb_get_property_reply_t *name = (net_wm_name != NULL) ? net_wm_name : wm_name;
+    if (name != NULL)
+    {
+        copy_property_string(name, 0, properties->title, sizeof(properties->title));
+        properties->has_title = true;
+    }
+    free(net_wm_name);
+    free(wm_name);
+
+    // Collect the `res_class` part of `WM_CLASS`.
+    xcb_get_property_reply_t *wm_class = collect_property(connection, request->wm_class);
+    parse_wm_class(wm_class, properties);
+    free(wm_class);
+
+    // Collect the window type.
+    xcb_get_property_reply_t *window_type = collect_property(connection, request->window_type);
+    parse_window_type(window_type, properties);
+    free(window_type);
+
+    // Collect the Motif hints.
+    xcb_get_property_reply_t *motif_hints = collect_property(connection, request->motif_hints);
+    parse_motif_hints(motif_hints, properties);
+    free(motif_hints);
+
+    // Collect the transient-for window.
+    xcb_get_property_reply_t *transient_for = collect_property(connection, request->transient_for);
+    parse_transient_for(transient_for, properties);
+    free(transient_for);
+
+    // Collect the normal hints.
+    xcb_get_property_reply_t *normal_hints = collect_property(connection, request->normal_hints);
+    parse_normal_hints(normal_hints, properties);
+    free(normal_hints);
+
+    // Collect the PID.
+    int count = 0;
+    xcb_get_property_reply_t *pid = collect_property(connection, request->pid);
+    uint32_t *pids = get_property_items(pid, &count);
+    if (count == 1) properties->pid = (pid_t)pids[0];
+    free(pid);
+
+    // Collect the desktop.
+    xcb_get_property_reply_t *desktop = collect_property(connection, request->desktop);
+    uint32_t *desktops = get_property_items(desktop, &count);
+    if (count == 1) properties->desktop = (int)desktops[0];
+    free(desktop);
+
+    end_timeline_span(&span);
+
+    // The window is gone if even its attributes are unavailable.
+    return (properties->parent != None) ? 0 : -1;
+}
+
+int collect_portal_properties(PortalPropertiesRequest *request, PortalProperties *out_properties)
+{
+    // Replies to requests issued before the last wait arrive without another
+    // round trip, only count the wait when this request was issued after it.
+    if ((int)(request->desktop.sequence - waited_through_sequence) <= 0)
+    {
+        return collect_portal_replies(request, out_properties);
+    }
+    waited_through_sequence = last_requested_sequence;
+    return X_REPLY_ROUND_TRIP(collect_portal_replies, request, out_properties);
+}
+
+int fetch_portal_properties(Window window, PortalProperties *out_properties)
+{
+    PortalPropertiesRequest request = request_portal_properties(window);
+    return collect_portal_properties(&request, out_properties);
+}
+
+HANDLE(PropertyNotify)
+{
+    XPropertyEvent *_event = &event->xproperty;
+
+    // Ensure the property change is related to a portal client window.
+    Portal *portal = find_portal_by_window(_event->window);
+    if (portal == NULL || portal->client_window != _event->window) return;
+    if (!portal->cold->properties.fetched) return;
+
+    // Ensure the property change is related to a cached property, the title
+    // is kept current separately.
+    Atom atom = _event->atom;
+    if (atom != XA_WM_NORMAL_HINTS &&
+        atom != XA_WM_CLASS &&
+        atom != XA_WM_TRANSIENT_FOR &&
+        atom != ATOM(_NET_WM_WINDOW_TYPE) &&
+        atom != ATOM(_MOTIF_WM_HINTS)
+    ) {
+        return;
+    }
+
+    // Refetch only the changed property, as the geometry and parent of
+    // framed clients are no longer root-relative, unlike the cached ones.
+    xcb_connection_t *connection = XGetXCBConnection(DefaultDisplay);
+    xcb_get_property_cookie_t cookie = request_tracked_property(connection, portal->client_window, atom);
+    xcb_get_property_reply_t *reply = X_REPLY_ROUND_TRIP(collect_property, connection, cookie);
+    parse_tracked_property(atom, reply, &portal->cold->properties);
+    free(reply);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "../all.h"
+
+/** The maximum length of cached string properties, including terminator. */
+#define PORTAL_PROPERTY_STRING_LENGTH 256
+
+/**
+ * The client window state and properties of a portal, fetched in a single
+ * pipelined batch and cached on the portal.
+ */
+typedef struct {
+    bool fetched;                    // Whether the properties were fetched.
+    bool viewable;                   // Whether the window was viewable.
+    bool override_redirect;
+    int window_class;                // `InputOutput` or `InputOnly`.
+    Visual *visual;
+    Window parent;
+    int x, y;                        // Position relative to the parent.
+    unsigned int width, height;
+    bool has_title;
+    char title[PORTAL_PROPERTY_STRING_LENGTH];
+    char wm_class[PORTAL_PROPERTY_STRING_LENGTH]; // `res_class` of `WM_CLASS`.
+    Atom window_type;                // First `_NET_WM_WINDOW_TYPE`, or normal.
+    bool wants_decorations;          // Whether Motif hints allow decorations.
+    Window transient_for;            // `None` if not transient.
+    bool has_normal_hints;
+    XSizeHints normal_hints;
+    pid_t pid;                       // -1 if unknown.
+    int desktop;                     // -1 if unknown.
+} PortalProperties;
+
+/**
+ * A pending batch of requests for the properties of a client window, as
+ * issued by `request_portal_properties()`.
+ */
+typedef struct {
+    Window window;
+    xcb_get_window_attributes_cookie_t attributes;
+    xcb_get_geometry_cookie_t geometry;
+    xcb_query_tree_cookie_t tree;
+    xcb_get_property_cookie_t net_wm_name;
+    xcb_get_property_cookie_t wm_name;
+    xcb_get_property_cookie_t wm_class;
+    xcb_get_property_cookie_t window_type;
+    xcb_get_property_cookie_t motif_hints;
+    xcb_get_property_cookie_t transient_for;
+    xcb_get_property_cookie_t normal_hints;
+    xcb_get_property_cookie_t pid;
+    xcb_get_property_cookie_t desktop;
+} PortalPropertiesRequest;
+
+/**
+ * Issues all requests for the properties of a client window at once, without
+ * waiting for their replies.
+ *
+ * @param window The client window.
+ *
+ * @return - `PortalPropertiesRequest` - The pending requests, to be passed to
+ * `collect_portal_properties()`.
+ *
+ * @note Issue the requests for multiple windows before collecting any of
+ * them, so all replies arrive within a single round trip.
+ */
+PortalPropertiesRequest request_portal_properties(Window window);
+
+/**
+ * Collects the replies of a pending batch of property requests.
+ *
+ * @param request The pending requests.
+ * @param out_properties Pointer to store the collected properties.
+ *
+ * @return - `0` The properties were collected successfully.
+ * @return - `-1` The window does not exist (anymore).
+ *
+ * @warning - Every request must be collected exactly once.
+ */
+int collect_portal_properties(PortalPropertiesRequest *request, PortalProperties *out_properties);
+
+/**
+ * Fetches the properties of a client window in a single round trip.
+ *
+ * @param window The client window.
+ * @param out_properties Pointer to store the fetched properties.
+ *
+ * @return - `0` The properties were fetched successfully.
+ * @return - `-1` The window does not exist (anymore).
+ */
+int fetch_portal_properties(Window window, PortalProperties *out_properties);
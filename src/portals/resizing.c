@@ -41,13 +41,13 @@ void update_resizing_portal(int mouse_root_x, int mouse_root_y, Time event_time)
     // Determine minimum dimensions from client hints or use defaults.
     int min_width = MINIMUM_PORTAL_WIDTH;
     int min_height = MINIMUM_PORTAL_HEIGHT;
-    XSizeHints hints;
-    if (XGetWMNormalHints(DefaultDisplay, resized_portal->client_window, &hints, &(long){0}))
+    XSizeHints *hints = &resized_portal->cold->properties.normal_hints;
+    if (resized_portal->cold->properties.has_normal_hints)
     {
-        if (hints.flags & PMinSize)
+        if (hints->flags & PMinSize)
         {
-            min_width = common.int_max(MINIMUM_PORTAL_WIDTH, hints.min_width);
-            min_height = common.int_max(MINIMUM_PORTAL_HEIGHT, hints.min_height);
+            min_width = common.int_max(MINIMUM_PORTAL_WIDTH, hints->min_width);
+            min_height = common.int_max(MINIMUM_PORTAL_HEIGHT, hints->min_height);
             if (is_portal_frame_valid(resized_portal))
             {
                 min_height += PORTAL_TITLE_BAR_HEIGHT;
@@ -0,0 +1,236 @@
+/**
+ * This code is responsible for mirroring the stacking order of the root
+ * window children. The order is maintained incrementally from the restack
+ * requests of the window manager and from the structure events of the root
+ * window, so it never has to be queried from the X server after startup,
+ * unless an event references a window that is not known.
+ */
+
+#include "../all.h"
+
+static Window *stacked_windows = NULL;
+static unsigned int stacked_window_count = 0;
+static unsigned int stacked_window_capacity = 0;
+
+/** Whether the mirrored stacking order could have diverged. */
+static bool window_stack_uncertain = true;
+
+static int find_stacked_window(Window window)
+{
+    for (unsigned int i = 0; i < stacked_window_count; i++)
+    {
+        if (stacked_windows[i] == window) return (int)i;
+    }
+    return -1;
+}
+
+static int reserve_stacked_windows(unsigned int capacity)
+{
+    if (capacity <= stacked_window_capacity) return 0;
+
+    // Grow the capacity by doubling it, until it is large enough.
+    unsigned int new_capacity = (stacked_window_capacity == 0)
+        ? WINDOW_STACK_INITIAL_CAPACITY
+        : stacked_window_capacity;
+    while (new_capacity < capacity) new_capacity *= 2;
+
+    Window *new_windows = realloc(stacked_windows, new_capacity * sizeof(Window));
+    if (new_windows == NULL) return -1;
+    stacked_windows = new_windows;
+    stacked_window_capacity = new_capacity;
+
+    return 0;
+}
+
+static void remove_stacked_window(Window window)
+{
+    int index = find_stacked_window(window);
+    if (index == -1) return;
+
+    // Shift subsequent windows down to close the gap.
+    memmove(
+        &stacked_windows[index],
+        &stacked_windows[index + 1],
+        (stacked_window_count - index - 1) * sizeof(Window)
+    );
+    stacked_window_count--;
+}
+
+static void insert_stacked_window(Window window, unsigned int index)
+{
+    // Ensure there is room for the window.
+    if (reserve_stacked_windows(stacked_window_count + 1) != 0)
+    {
+        LOG_ERROR("Could not mirror window stacking, memory allocation failed.");
+        window_stack_uncertain = true;
+        return;
+    }
+
+    // Shift subsequent windows up to make room.
+    memmove(
+        &stacked_windows[index + 1],
+        &stacked_windows[index],
+        (stacked_window_count - index) * sizeof(Window)
+    );
+    stacked_windows[index] = window;
+    stacked_window_count++;
+}
+
+static void restack_window_above(Window window, Window sibling)
+{
+    // Remove the window from its current position, if any.
+    remove_stacked_window(window);
+
+    // Place the window at the bottom, if there is no sibling below it.
+    if (sibling == None)
+    {
+        insert_stacked_window(window, 0);
+        return;
+    }
+
+    // Place the window directly above its sibling. If the sibling is not
+    // known, the mirrored order can't be trusted anymore.
+    int sibling_index = find_stacked_window(sibling);
+    if (sibling_index == -1)
+    {
+        insert_stacked_window(window, stacked_window_count);
+        window_stack_uncertain = true;
+        return;
+    }
+    insert_stacked_window(window, sibling_index + 1);
+}
+
+int set_window_stack(const Window *windows, unsigned int window_count)
+{
+    // Ensure there is room for the windows.
+    if (reserve_stacked_windows(window_count) != 0)
+    {
+        window_stack_uncertain = true;
+        return -1;
+    }
+
+    // Copy the windows.
+    if (window_count > 0)
+    {
+        memcpy(stacked_windows, windows, window_count * sizeof(Window));
+    }
+    stacked_window_count = window_count;
+    window_stack_uncertain = false;
+
+    return 0;
+}
+
+int synchronize_window_stack()
+{
+    Display *display = DefaultDisplay;
+    Window root_window = DefaultRootWindow(display);
+
+    // Query the root window children, in stacking order.
+    Window *children = NULL;
+    unsigned int child_count = 0;
+    if (!X_ROUND_TRIP(XQueryTree,
+        display,        // Display
+        root_window,    // Window
+        &(Window){0},   // Root window (Unused)
+        &(Window){0},   // Parent window (Unused)
+        &children,      // Children
+        &child_count    // Children count
+    ))
+    {
+        window_stack_uncertain = true;
+        return -1;
+    }
+
+    // Replace the mirrored stacking order.
+    int status = set_window_stack(children, child_count);
+    if (children != NULL) XFree(children);
+    return (status == 0) ? 0 : -2;
+}
+
+bool is_window_stack_uncertain()
+{
+    return window_stack_uncertain;
+}
+
+void raise_stacked_window(Window window)
+{
+    remove_stacked_window(window);
+    insert_stacked_window(window, stacked_window_count);
+}
+
+const Window *get_stacked_windows(unsigned int *out_count)
+{
+    *out_count = stacked_window_count;
+    return stacked_windows;
+}
+
+HANDLE(CreateNotify)
+{
+    XCreateWindowEvent *_event = &event->xcreatewindow;
+    if (_event->parent != DefaultRootWindow(DefaultDisplay)) return;
+
+    // New windows are placed on top of their siblings.
+    raise_stacked_window(_event->window);
+    sort_portals();
+}
+
+HANDLE(DestroyNotify)
+{
+    XDestroyWindowEvent *_event = &event->xdestroywindow;
+    if (_event->event != DefaultRootWindow(DefaultDisplay)) return;
+
+    remove_stacked_window(_event->window);
+    sort_portals();
+}
+
+HANDLE(ReparentNotify)
+{
+    XReparentEvent *_event = &event->xreparent;
+    Window root_window = DefaultRootWindow(DefaultDisplay);
+    if (_event->event != root_window) return;
+
+    // Windows reparented to root are placed on top of their siblings, while
+    // windows reparented elsewhere are no longer root window children.
+    if (_event->parent == root_window)
+    {
+        raise_stacked_window(_event->window);
+    }
+    else
+    {
+        remove_stacked_window(_event->window);
+    }
+    sort_portals();
+}
+
+HANDLE(ConfigureNotify)
+{
+    XConfigureEvent *_event = &event->xconfigure;
+    if (_event->event != DefaultRootWindow(DefaultDisplay)) return;
+
+    // Place the window directly above the sibling reported by the server.
+    // Skip plain moves and resizes, which leave the order untouched.
+    int index = find_stacked_window(_event->window);
+    if (index != -1)
+    {
+        Window below = (index > 0) ? stacked_windows[index - 1] : None;
+        if (below == _event->above) return;
+    }
+    restack_window_above(_event->window, _event->above);
+    sort_portals();
+}
+
+HANDLE(CirculateNotify)
+{
+    XCirculateEvent *_event = &event->xcirculate;
+    if (_event->event != DefaultRootWindow(DefaultDisplay)) return;
+
+    if (_event->place == PlaceOnTop)
+    {
+        raise_stacked_window(_event->window);
+    }
+    else
+    {
+        restack_window_above(_event->window, None);
+    }
+    sort_portals();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../all.h"
+
+/** The initial capacity of the mirrored window stack. */
+#define WINDOW_STACK_INITIAL_CAPACITY 128
+
+/**
+ * Replaces the mirrored stacking order of the root window children.
+ *
+ * @param windows The root window children, in stacking order (bottom to top).
+ * @param window_count The number of windows.
+ *
+ * @return - `0` The stacking order was replaced successfully.
+ * @return - `-1` Memory allocation failed, the stacking order is uncertain.
+ */
+int set_window_stack(const Window *windows, unsigned int window_count);
+
+/**
+ * Replaces the mirrored stacking order of the root window children with the
+ * actual stacking order, using a single `XQueryTree()` call.
+ *
+ * @return - `0` The stacking order was synchronized successfully.
+ * @return - `-1` The tree query failed.
+ * @return - `-2` Memory allocation failed.
+ */
+int synchronize_window_stack();
+
+/**
+ * Checks whether the mirrored stacking order could have diverged from the
+ * actual stacking order, and should be synchronized before being used.
+ *
+ * @return - `true` The stacking order is uncertain.
+ * @return - `false` The stacking order is up to date.
+ */
+bool is_window_stack_uncertain();
+
+/**
+ * Moves a window to the top of the mirrored stacking order, as done by the
+ * X server for `XRaiseWindow()`.
+ *
+ * @param window The root window child to raise.
+ */
+void raise_stacked_window(Window window);
+
+/**
+ * Retrieves the mirrored stacking order of the root window children.
+ *
+ * @param out_count Pointer to store the number of windows.
+ *
+ * @return The windows, in stacking order (bottom to top).
+ */
+const Window *get_stacked_windows(unsigned int *out_count);
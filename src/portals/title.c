@@ -5,15 +5,15 @@ static void set_portal_title(Portal *portal, const char *title)
     char *new_title = strdup(title);
     if (new_title != NULL)
     {
-        free(portal->title);
-        portal->title = new_title;
+        free(portal->cold->title);
+        portal->cold->title = new_title;
     }
 }
 
 void draw_portal_title(Portal *portal)
 {
     const Theme *theme = get_portal_theme(portal);
-    cairo_t *cr = portal->frame_cr;
+    cairo_t *cr = portal->cold->frame_cr;
     unsigned int width = portal->geometry.width;
 
     // Set the font and color.
@@ -27,13 +27,13 @@ void draw_portal_title(Portal *portal)
 
     // Determine the position for the title text.
     cairo_text_extents_t title_extents;
-    cairo_text_extents(cr, portal->title, &title_extents);
+    cairo_text_extents(cr, portal->cold->title, &title_extents);
     double title_x = (width - title_extents.width) / 2 - title_extents.x_bearing;
     double title_y = (PORTAL_TITLE_BAR_HEIGHT - title_extents.height) / 2 - title_extents.y_bearing;
     cairo_move_to(cr, title_x, title_y);
 
     // Draw the title text.
-    cairo_show_text(cr, portal->title);
+    cairo_show_text(cr, portal->cold->title);
 }
 
 HANDLE(PropertyNotify)
@@ -46,8 +46,8 @@ HANDLE(PropertyNotify)
     if (portal == NULL) return;
 
     // Ensure the property change is related to the window title.
-    Atom _NET_WM_NAME = XInternAtom(display, "_NET_WM_NAME", False);
-    Atom WM_NAME = XInternAtom(display, "WM_NAME", False);
+    Atom _NET_WM_NAME = ATOM(_NET_WM_NAME);
+    Atom WM_NAME = ATOM(WM_NAME);
     if (_event->atom != WM_NAME && _event->atom != _NET_WM_NAME) return;
 
     // Retrieve the client window title, and update the portal title.
@@ -55,6 +55,7 @@ HANDLE(PropertyNotify)
     if (x_get_window_name(display, portal->client_window, title, sizeof(title)) == 0)
     {
         set_portal_title(portal, title);
+        snprintf(portal->cold->properties.title, sizeof(portal->cold->properties.title), "%s", title);
         draw_portal_frame(portal);
     }
 }
@@ -55,7 +55,7 @@ static bool is_portal_trigger_area(Portal *portal, PortalTriggerType type, int r
 
 static void draw_portal_trigger(Portal *portal, PortalTriggerType type)
 {
-    cairo_t *cr = portal->frame_cr;
+    cairo_t *cr = portal->cold->frame_cr;
     const Theme *theme = get_portal_theme(portal);
 
     // Calculate trigger position.
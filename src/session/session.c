@@ -0,0 +1,390 @@
+/**
+ * This code is responsible for preserving the session state across window
+ * manager restarts. A compact, versioned snapshot is kept in a property of
+ * the root window, which outlives the window manager process, and restored
+ * while adopting the existing windows, so an upgrade doesn't cost a relayout.
+ *
+ * The snapshot is an array of 32-bit items: a header, a record per workspace
+ * and a record per portal, keyed by client window.
+ */
+
+#include "../all.h"
+
+/** The number of items in the snapshot header. */
+#define SESSION_HEADER_ITEMS 4
+
+/** The number of items in each workspace record. */
+#define SESSION_WORKSPACE_ITEMS 2
+
+/** The number of items in each portal record. */
+#define SESSION_PORTAL_ITEMS 8
+
+/** A type representing the restorable state of a single portal. */
+typedef struct {
+    Window client_window;
+    int workspace;
+    int tile_position;               // -1 if not in a tile order.
+    PortalGeometry floating;         // The floating geometry backup.
+    ThemeVariant theme;
+} SessionPortalRecord;
+
+/** The portal records of the snapshot being restored, if any. */
+static SessionPortalRecord *restored_records = NULL;
+static int restored_record_count = 0;
+
+/** The last focused client window of each workspace being restored. */
+static Window restored_last_focused[MAX_WORKSPACES] = {None};
+
+/** Whether the session state changed since the last snapshot was written. */
+static bool session_dirty = false;
+
+/** When the last snapshot was written. */
+static Time last_save_time = 0;
+
+static SessionPortalRecord *find_restored_record(Window client_window)
+{
+    for (int i = 0; i < restored_record_count; i++)
+    {
+        if (restored_records[i].client_window == client_window)
+        {
+            return &restored_records[i];
+        }
+    }
+    return NULL;
+}
+
+static int find_tile_position(Portal *portal, int workspace)
+{
+    int tile_count = 0;
+    Portal **tiles = get_tile_order(workspace, &tile_count);
+    for (int i = 0; i < tile_count; i++)
+    {
+        if (tiles[i] == portal) return i;
+    }
+    return -1;
+}
+
+static void finish_session_restore()
+{
+    free(restored_records);
+    restored_records = NULL;
+    restored_record_count = 0;
+}
+
+int save_session_state()
+{
+    Display *display = DefaultDisplay;
+    Window root_window = DefaultRootWindow(display);
+
+    // Allocate memory for the largest possible snapshot.
+    unsigned int active_count = 0;
+    Portal **portals = get_active_portals(&active_count);
+    size_t capacity = SESSION_HEADER_ITEMS +
+        MAX_WORKSPACES * SESSION_WORKSPACE_ITEMS +
+        active_count * SESSION_PORTAL_ITEMS;
+    long *items = malloc(capacity * sizeof(long));
+    if (items == NULL)
+    {
+        LOG_ERROR("Could not save session state, memory allocation failed.");
+        return -1;
+    }
+
+    // Write the workspace records, counting the focused portal as the last
+    // focused one of its workspace.
+    Portal *focused_portal = get_focused_portal();
+    size_t count = SESSION_HEADER_ITEMS;
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        Portal *last_focused = get_last_focused_portal(i);
+        if (focused_portal != NULL && focused_portal->workspace == i)
+        {
+            last_focused = focused_portal;
+        }
+        items[count++] = get_workspace_layout_mode(i);
+        items[count++] = (last_focused != NULL) ? (long)last_focused->client_window : None;
+    }
+
+    // Write the portal records of managed top-level portals.
+    long portal_count = 0;
+    for (unsigned int i = 0; i < active_count; i++)
+    {
+        Portal *portal = portals[i];
+        if (!portal->initialized) continue;
+        if (!portal->top_level) continue;
+
+        items[count++] = portal->client_window;
+        items[count++] = portal->workspace;
+        items[count++] = find_tile_position(portal, portal->workspace);
+        items[count++] = portal->cold->geometry_floating_backup.x_root;
+        items[count++] = portal->cold->geometry_floating_backup.y_root;
+        items[count++] = portal->cold->geometry_floating_backup.width;
+        items[count++] = portal->cold->geometry_floating_backup.height;
+        items[count++] = portal->theme;
+        portal_count++;
+    }
+
+    // Write the header.
+    items[0] = SESSION_STATE_MAGIC;
+    items[1] = SESSION_STATE_VERSION;
+    items[2] = MAX_WORKSPACES;
+    items[3] = portal_count;
+
+    // Replace the snapshot on the root window.
+    XChangeProperty(
+        display,                    // Display
+        root_window,                // Window
+        ATOM(_LIMEOS_WM_STATE),     // Property
+        XA_CARDINAL,                // Type
+        32,                         // Format (32-bit)
+        PropModeReplace,            // Mode
+        (unsigned char *)items,     // Data
+        (int)count                  // Element count
+    );
+
+    free(items);
+    session_dirty = false;
+    return 0;
+}
+
+int load_session_state()
+{
+    Display *display = DefaultDisplay;
+    Window root_window = DefaultRootWindow(display);
+
+    // Retrieve the snapshot from the root window.
+    unsigned char *data = NULL;
+    unsigned long item_count = 0;
+    int format = 0;
+    int status = X_ROUND_TRIP(XGetWindowProperty,
+        display,                    // Display
+        root_window,                // Window
+        ATOM(_LIMEOS_WM_STATE),     // Property
+        0, (~0L),                   // Offset, length
+        False,                      // Delete
+        XA_CARDINAL,                // Type
+        &(Atom){0},                 // Actual type (unused)
+        &format,                    // Actual format
+        &item_count,                // N items
+        &(unsigned long){0},        // Bytes after (unused)
+        &data                       // Data
+    );
+    if (status != Success || data == NULL) return -1;
+
+    // Ensure the snapshot is well-formed and of the supported version.
+    long *items = (long *)data;
+    if (format != 32 ||
+        item_count < SESSION_HEADER_ITEMS ||
+        items[0] != SESSION_STATE_MAGIC ||
+        items[1] != SESSION_STATE_VERSION ||
+        items[2] != MAX_WORKSPACES ||
+        items[3] < 0 ||
+        item_count != SESSION_HEADER_ITEMS +
+            MAX_WORKSPACES * SESSION_WORKSPACE_ITEMS +
+            (unsigned long)items[3] * SESSION_PORTAL_ITEMS)
+    {
+        LOG_WARNING("Ignoring session state, snapshot is malformed or of another version.");
+        XFree(data);
+        return -2;
+    }
+
+    // Allocate memory for the portal records.
+    int record_count = (int)items[3];
+    SessionPortalRecord *records = calloc(record_count > 0 ? record_count : 1, sizeof(SessionPortalRecord));
+    if (records == NULL)
+    {
+        LOG_ERROR("Could not load session state, memory allocation failed.");
+        XFree(data);
+        return -3;
+    }
+
+    // Restore the workspace layout modes right away, so adopted portals are
+    // arranged according to them, and keep the last focused windows.
+    const long *item = items + SESSION_HEADER_ITEMS;
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        WorkspaceLayoutMode mode = (item[0] == WORKSPACE_LAYOUT_TILING)
+            ? WORKSPACE_LAYOUT_TILING
+            : WORKSPACE_LAYOUT_FLOATING;
+        set_workspace_layout_mode(i, mode);
+        restored_last_focused[i] = (Window)item[1];
+        item += SESSION_WORKSPACE_ITEMS;
+    }
+
+    // Read the portal records.
+    for (int i = 0; i < record_count; i++)
+    {
+        records[i] = (SessionPortalRecord){
+            .client_window = (Window)item[0],
+            .workspace = (int)item[1],
+            .tile_position = (int)item[2],
+            .floating = {
+                .x_root = (int)item[3],
+                .y_root = (int)item[4],
+                .width = (unsigned int)item[5],
+                .height = (unsigned int)item[6]
+            },
+            .theme = (ThemeVariant)item[7]
+        };
+        item += SESSION_PORTAL_ITEMS;
+    }
+    XFree(data);
+
+    // Replace the records of any earlier restore.
+    finish_session_restore();
+    restored_records = records;
+    restored_record_count = record_count;
+    return 0;
+}
+
+bool is_restoring_session_state()
+{
+    return restored_records != NULL;
+}
+
+static void save_session_state_at_exit()
+{
+    // Ensure the connection is still usable, after a fatal I/O error any
+    // request would fail again from within exit().
+    if (x_is_connection_lost()) return;
+
+    // Write the final snapshot, and flush it as nothing else will.
+    if (save_session_state() == 0)
+    {
+        XFlush(DefaultDisplay);
+    }
+}
+
+HANDLE(PortalInitialized)
+{
+    PortalInitializedEvent *_event = &event->portal_initialized;
+    Portal *portal = _event->portal;
+
+    // Ensure the portal has a record in the snapshot being restored.
+    if (!is_restoring_session_state()) return;
+    SessionPortalRecord *record = find_restored_record(portal->client_window);
+    if (record == NULL) return;
+
+    // Restore the workspace assignment, unless `_NET_WM_DESKTOP` provided it.
+    if (portal->workspace == -1 && record->workspace >= 0 && record->workspace < MAX_WORKSPACES)
+    {
+        portal->workspace = record->workspace;
+    }
+
+    // Restore the floating geometry backup and the resolved theme variant.
+    portal->cold->geometry_floating_backup = record->floating;
+    if (portal->theme == THEME_VARIANT_UNRESOLVED)
+    {
+        portal->theme = record->theme;
+    }
+
+    // Restore the tile order position, placing the portal after those with
+    // an earlier position that were restored before it.
+    if (record->tile_position < 0) return;
+    int workspace = determine_portal_workspace(portal);
+    if (get_workspace_layout_mode(workspace) != WORKSPACE_LAYOUT_TILING) return;
+    int tile_count = 0;
+    Portal **tiles = get_tile_order(workspace, &tile_count);
+    int position = 0;
+    for (int i = 0; i < tile_count; i++)
+    {
+        SessionPortalRecord *other = find_restored_record(tiles[i]->client_window);
+        if (other != NULL && other->tile_position < record->tile_position)
+        {
+            position = i + 1;
+        }
+    }
+    insert_into_tile_order(portal, workspace, position);
+}
+
+HANDLE(PortalsAdopted)
+{
+    if (!is_restoring_session_state()) return;
+
+    // Restore the last focused portal of each workspace.
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        if (restored_last_focused[i] == None) continue;
+        Portal *portal = find_portal_by_window(restored_last_focused[i]);
+        if (portal != NULL && portal->workspace == i)
+        {
+            set_last_focused_portal(i, portal);
+        }
+        restored_last_focused[i] = None;
+    }
+
+    // Arrange the restored tile orders, which leaves unchanged portals
+    // untouched, and reset workspaces that ended up without tiles.
+    begin_portal_transaction();
+    for (int i = 0; i < MAX_WORKSPACES; i++)
+    {
+        if (get_workspace_layout_mode(i) != WORKSPACE_LAYOUT_TILING) continue;
+        if (get_tile_order_count(i) == 0)
+        {
+            set_workspace_layout_mode(i, WORKSPACE_LAYOUT_FLOATING);
+            continue;
+        }
+        arrange_workspace_portals(i);
+    }
+    commit_portal_transaction();
+
+    finish_session_restore();
+    session_dirty = true;
+}
+
+HANDLE(PortalMapped)
+{
+    session_dirty = true;
+}
+
+HANDLE(PortalDestroyed)
+{
+    session_dirty = true;
+}
+
+HANDLE(PortalTransformed)
+{
+    session_dirty = true;
+}
+
+HANDLE(PortalFocused)
+{
+    session_dirty = true;
+}
+
+HANDLE(PortalWorkspaceChanged)
+{
+    session_dirty = true;
+}
+
+HANDLE(WorkspaceSwitched)
+{
+    session_dirty = true;
+}
+
+HANDLE(ShortcutPressed)
+{
+    // Layout mode changes have no event of their own.
+    session_dirty = true;
+}
+
+HANDLE(Update)
+{
+    // Write the snapshot at most once per interval, and never mid-adoption
+    // or mid-interaction. Every write notifies all clients selecting
+    // property changes on the root window, such as panels and pagers.
+    if (!session_dirty) return;
+    if (is_adopting_portal_windows()) return;
+    if (is_portal_dragging() || is_portal_resizing()) return;
+    if (x_get_current_time() - last_save_time < SESSION_SAVE_INTERVAL_MS) return;
+    save_session_state();
+    last_save_time = x_get_current_time();
+}
+
+HANDLE(Initialize)
+{
+    // Leave the snapshot of the live session alone while replaying.
+    if (is_event_replay_requested()) return;
+
+    // Write the final snapshot at exit, whichever way the process ends.
+    atexit(save_session_state_at_exit);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "../all.h"
+
+/** The identifier at the start of every session state snapshot. */
+#define SESSION_STATE_MAGIC 0x4C4D5753
+
+/** The version of the session state snapshot layout, bump on changes. */
+#define SESSION_STATE_VERSION 1
+
+/** The minimum interval between two snapshot writes in milliseconds. */
+#define SESSION_SAVE_INTERVAL_MS 1000
+
+/**
+ * Writes a snapshot of the session state to the `_LIMEOS_WM_STATE` property
+ * of the root window, so a restarted window manager can recover it.
+ *
+ * The snapshot holds the layout mode, tile order and last focused portal of
+ * each workspace, and the floating geometry and theme variant of each portal.
+ *
+ * @return - `0` The snapshot was written successfully.
+ * @return - `-1` Memory allocation failed.
+ *
+ * @note The snapshot is written automatically once per frame after changes,
+ * and at exit.
+ */
+int save_session_state();
+
+/**
+ * Loads the session state snapshot left behind by a previous window manager
+ * instance, and restores the workspace layout modes from it. The remaining
+ * state is restored as portals are initialized, until `PortalsAdopted`.
+ *
+ * @return - `0` The snapshot was loaded successfully.
+ * @return - `-1` No snapshot is available.
+ * @return - `-2` The snapshot is malformed or of an unsupported version.
+ * @return - `-3` Memory allocation failed.
+ *
+ * @note Called by `adopt_existing_portal_windows()` before adopting.
+ */
+int load_session_state();
+
+/**
+ * Checks whether a loaded session state snapshot is being restored.
+ *
+ * @return - `true` A snapshot is being restored, its state takes precedence
+ * over heuristics such as auto-tiling.
+ * @return - `false` No snapshot is being restored.
+ */
+bool is_restoring_session_state();
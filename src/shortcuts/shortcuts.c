@@ -65,7 +65,7 @@ static void grab_shortcut_keys(int *keys, int keys_size)
     for (int i = 0; i < keycode_count; i++)
     {
         if (keycodes[i] == 0) continue;
-        XIGrabKeycode(
+        X_ROUND_TRIP(XIGrabKeycode,
             display, XIAllMasterDevices, keycodes[i],
             root, GrabModeAsync, GrabModeAsync,
             True, &xi_mask, 4, xi_modifiers
@@ -15,6 +15,12 @@ static void handle_terminal_shortcut()
     // The code below will only execute in the forked child process.
     if (pid == 0)
     {
+        // Unblock the signals blocked by the event loop, as the signal mask is
+        // inherited by the terminal.
+        sigset_t signal_mask;
+        sigemptyset(&signal_mask);
+        sigprocmask(SIG_SETMASK, &signal_mask, NULL);
+
         // Replace the current process with the terminal.
         const char *command = get_terminal_command();
         char **args = common.split_string(command, " ", NULL);
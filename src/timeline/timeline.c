@@ -0,0 +1,120 @@
+/**
+ * This code is responsible for the optional timeline tracer. Spans (event loop
+ * iterations, handler invocations, compositor stages and X round trips) are
+ * kept in a fixed-size ring buffer in memory, so the tracer can stay enabled
+ * with bounded overhead, and are only written to disk on demand.
+ */
+
+#include "../all.h"
+
+static TimelineSpan *timeline_spans = NULL;
+static unsigned int timeline_head = 0;
+static unsigned int timeline_count = 0;
+
+static char timeline_path[COMMON_MAX_PATH_LENGTH] = "";
+
+bool is_timeline_enabled()
+{
+    return timeline_spans != NULL;
+}
+
+TimelineSpan begin_timeline_span(const char *category, const char *name)
+{
+    return (TimelineSpan){
+        .category = category,
+        .name = name,
+        .start_us = is_timeline_enabled() ? get_monotonic_time_us() : 0
+    };
+}
+
+void end_timeline_span(TimelineSpan *span)
+{
+    if (!is_timeline_enabled() || span->start_us == 0) return;
+    span->duration_us = get_monotonic_time_us() - span->start_us;
+
+    // Store the span, overwriting the oldest span if the buffer is full.
+    unsigned int index = (timeline_head + timeline_count) % TIMELINE_CAPACITY;
+    timeline_spans[index] = *span;
+    if (timeline_count < TIMELINE_CAPACITY)
+    {
+        timeline_count++;
+    }
+    else
+    {
+        timeline_head = (timeline_head + 1) % TIMELINE_CAPACITY;
+    }
+}
+
+int flush_timeline(const char *path)
+{
+    if (!is_timeline_enabled()) return -1;
+
+    // Open the timeline file.
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return -2;
+
+    // Write each span as a complete trace event, oldest first.
+    int pid = (int)getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (unsigned int i = 0; i < timeline_count; i++)
+    {
+        TimelineSpan *span = &timeline_spans[(timeline_head + i) % TIMELINE_CAPACITY];
+        fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+            "\"ts\":%lu,\"dur\":%lu,\"pid\":%d,\"tid\":%d",
+            (i == 0) ? "" : ",",
+            span->name, span->category,
+            (unsigned long)span->start_us, (unsigned long)span->duration_us,
+            pid, pid
+        );
+        if (span->file != NULL)
+        {
+            fprintf(file, ",\"args\":{\"location\":\"%s:%d\"}", span->file, span->line);
+        }
+        else if (span->window != 0)
+        {
+            fprintf(file, ",\"args\":{\"window\":\"0x%lx\"}", span->window);
+        }
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return 0;
+}
+
+HANDLE(Initialize)
+{
+    // Get the timeline path from the configuration, the tracer is disabled
+    // when no path is set.
+    char cfg_timeline_path[CONFIG_MAX_VALUE_LENGTH];
+    common.get_config_str(
+        cfg_timeline_path, sizeof(cfg_timeline_path),
+        CFG_KEY_TIMELINE_PATH, CFG_DEFAULT_TIMELINE_PATH
+    );
+    if (cfg_timeline_path[0] == '\0') return;
+    if (common.expand_path(cfg_timeline_path, timeline_path, sizeof(timeline_path)) != 0)
+    {
+        LOG_WARNING("Failed to expand timeline path (%s).", cfg_timeline_path);
+        return;
+    }
+
+    // Allocate the ring buffer, enabling the tracer.
+    timeline_spans = malloc(TIMELINE_CAPACITY * sizeof(TimelineSpan));
+    if (timeline_spans == NULL)
+    {
+        LOG_WARNING("Failed to allocate memory for the timeline.");
+    }
+}
+
+HANDLE(SignalReceived)
+{
+    SignalReceivedEvent *_event = &event->signal_received;
+
+    // Flush the timeline on demand.
+    if (_event->signal != SIGUSR2) return;
+    if (flush_timeline(timeline_path) == -2)
+    {
+        LOG_WARNING("Failed to write timeline (%s).", timeline_path);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "../all.h"
+
+/** The maximum number of spans kept in the timeline ring buffer. */
+#define TIMELINE_CAPACITY 65536
+
+/**
+ * A span of time on the timeline, exported as a trace event.
+ */
+typedef struct {
+    const char *category;
+    const char *name;
+    const char *file;      // Optional source file of the span.
+    int line;              // Optional source line of the span.
+    unsigned long window;  // Optional window the span relates to.
+    uint64_t start_us;
+    uint64_t duration_us;
+} TimelineSpan;
+
+/**
+ * Checks if the timeline tracer is enabled.
+ *
+ * @return - `true` - The timeline tracer is enabled.
+ * @return - `false` - The timeline tracer is disabled.
+ *
+ * @note - The timeline tracer is enabled by setting the timeline path in the
+ * configuration file.
+ */
+bool is_timeline_enabled();
+
+/**
+ * Begins a span on the timeline.
+ *
+ * @param category The category of the span (E.g. `"compositor"`).
+ * @param name The name of the span.
+ *
+ * @return - `TimelineSpan` - The begun span, to be ended using
+ * `end_timeline_span()`.
+ *
+ * @warning - The category and name strings are not copied, they must outlive
+ * the timeline (E.g. string literals).
+ * @note - When the timeline tracer is disabled, the span is never recorded.
+ */
+TimelineSpan begin_timeline_span(const char *category, const char *name);
+
+/**
+ * Ends a span and records it in the timeline ring buffer, overwriting the
+ * oldest span once the buffer is full.
+ *
+ * @param span The span to end.
+ */
+void end_timeline_span(TimelineSpan *span);
+
+/**
+ * Writes the spans in the timeline ring buffer to a file, formatted as
+ * trace event JSON (viewable in `chrome://tracing` or Perfetto).
+ *
+ * @param path The path of the file to write.
+ *
+ * @return - `0` - The timeline was written successfully.
+ * @return - `-1` - The timeline tracer is disabled.
+ * @return - `-2` - The file could not be opened.
+ *
+ * @note - The timeline is flushed to the configured path when the window
+ * manager receives `SIGUSR2`.
+ */
+int flush_timeline(const char *path);
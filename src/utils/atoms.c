@@ -0,0 +1,41 @@
+#include "../all.h"
+
+static char *atom_names[ATOM_ID_COUNT] = {
+#define X_ATOM_NAME(name) #name,
+    X_ATOMS(X_ATOM_NAME)
+#undef X_ATOM_NAME
+};
+
+static Atom atoms[ATOM_ID_COUNT] = {None};
+static bool atoms_interned = false;
+
+int intern_atoms(Display *display)
+{
+    // Intern all atoms in a single round trip.
+    atoms_interned = true;
+    Status status = X_ROUND_TRIP(XInternAtoms,
+        display,        // Display
+        atom_names,     // Names
+        ATOM_ID_COUNT,  // Count
+        False,          // Only if exists
+        atoms           // Atoms
+    );
+    if (status == 0)
+    {
+        LOG_ERROR("Could not intern all atoms.");
+        return -1;
+    }
+
+    return 0;
+}
+
+Atom get_atom(AtomId id)
+{
+    if (!atoms_interned) intern_atoms(DefaultDisplay);
+    return atoms[id];
+}
+
+HANDLE(Prepare)
+{
+    if (!atoms_interned) intern_atoms(DefaultDisplay);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "../all.h"
+
+/**
+ * The list of atoms used by the window manager, interned all at once by
+ * `intern_atoms()`. Add new atoms here instead of interning them ad hoc.
+ */
+#define X_ATOMS(X) \
+    X(UTF8_STRING) \
+    X(WM_NAME) \
+    X(WM_STATE) \
+    X(WM_PROTOCOLS) \
+    X(WM_DELETE_WINDOW) \
+    X(_MOTIF_WM_HINTS) \
+    X(_NET_SUPPORTED) \
+    X(_NET_SUPPORTING_WM_CHECK) \
+    X(_NET_WM_NAME) \
+    X(_NET_WM_PID) \
+    X(_NET_CLIENT_LIST) \
+    X(_NET_ACTIVE_WINDOW) \
+    X(_NET_WM_ACTION_MOVE) \
+    X(_NET_WM_ACTION_RESIZE) \
+    X(_NET_WM_MOVERESIZE) \
+    X(_NET_MOVERESIZE_WINDOW) \
+    X(_NET_CLOSE_WINDOW) \
+    X(_NET_FRAME_EXTENTS) \
+    X(_NET_WM_STATE) \
+    X(_NET_WM_STATE_FULLSCREEN) \
+    X(_NET_WM_WINDOW_TYPE) \
+    X(_NET_WM_WINDOW_TYPE_NORMAL) \
+    X(_NET_WM_WINDOW_TYPE_DOCK) \
+    X(_NET_WM_WINDOW_TYPE_SPLASH) \
+    X(_NET_WM_WINDOW_TYPE_TOOLTIP) \
+    X(_NET_WM_WINDOW_TYPE_NOTIFICATION) \
+    X(_NET_NUMBER_OF_DESKTOPS) \
+    X(_NET_CURRENT_DESKTOP) \
+    X(_NET_DESKTOP_NAMES) \
+    X(_NET_WM_DESKTOP) \
+    X(_LIMEOS_WM_STATE) \
+    X(_LIMEOS_DESKTOP_THUMBNAILS)
+
+/** A type representing the identifier of an atom in the atom table. */
+typedef enum
+{
+#define X_ATOM_ID(name) ATOM_ID_##name,
+    X_ATOMS(X_ATOM_ID)
+#undef X_ATOM_ID
+    ATOM_ID_COUNT
+} AtomId;
+
+/**
+ * Retrieves an atom from the atom table by its name.
+ *
+ * @param name The atom name, without quotes (E.g. `_NET_WM_NAME`).
+ */
+#define ATOM(name) get_atom(ATOM_ID_##name)
+
+/**
+ * Interns all atoms of the atom table with a single `XInternAtoms()` call.
+ *
+ * @param display The X11 display.
+ *
+ * @return - `0` The atoms were interned successfully.
+ * @return - `-1` Not all atoms could be interned.
+ */
+int intern_atoms(Display *display);
+
+/**
+ * Retrieves an atom from the atom table.
+ *
+ * @param id The identifier of the atom.
+ *
+ * @return The atom, or `None` if it could not be interned.
+ *
+ * @note Interns the atom table first if that hasn't happened yet, so atoms
+ * can be used from `Prepare` handlers regardless of their order.
+ */
+Atom get_atom(AtomId id);
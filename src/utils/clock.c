@@ -0,0 +1,15 @@
+#include "../all.h"
+
+uint64_t get_monotonic_time_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000UL + (uint64_t)now.tv_nsec / 1000UL;
+}
+
+uint64_t get_monotonic_time_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000UL + (uint64_t)now.tv_nsec;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "../all.h"
+
+/**
+ * Retrieves the time of the monotonic clock in microseconds.
+ *
+ * @return The monotonic time in microseconds.
+ */
+uint64_t get_monotonic_time_us();
+
+/**
+ * Retrieves the time of the monotonic clock in nanoseconds.
+ *
+ * @return The monotonic time in nanoseconds.
+ */
+uint64_t get_monotonic_time_ns();
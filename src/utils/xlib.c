@@ -2,15 +2,41 @@
 
 static Display *default_display = NULL;
 
-static int trapped_error_code = 0;
-static int (*prev_error_handler)(Display *, XErrorEvent *) = NULL;
-
-static int trap_error_handler(Display *display, XErrorEvent *error)
-{
-    (void)display;
-    trapped_error_code = error->error_code;
-    return 0;
-}
+typedef struct {
+    const char *function;
+    const char *file;
+    int line;
+    unsigned long count;
+    uint64_t total_ns;
+} XRoundTripSite;
+
+typedef struct {
+    unsigned long count;
+    uint64_t total_ns;
+} XRoundTripTotals;
+
+static XRoundTripSite round_trip_sites[X_MAX_ROUND_TRIP_SITES] = {{0}};
+static int round_trip_site_count = 0;
+static XRoundTripTotals round_trips_per_event_type[MAX_EVENT_TYPES] = {{0}};
+static XRoundTripTotals round_trips_outside_handlers = {0};
+static XRoundTripTotals round_trips_total = {0};
+
+typedef struct {
+    unsigned long first_request;
+    unsigned long last_request;
+    XErrorCallback *callback;
+    void *data;
+} XErrorRange;
+
+/**
+ * The tracked error ranges, in the order they were registered (and therefore
+ * in increasing request order).
+ */
+static XErrorRange error_ranges[X_MAX_ERROR_RANGES] = {{0}};
+static int error_range_head = 0;
+static int error_range_count = 0;
+
+static bool connection_lost = false;
 
 void x_set_default_display(Display *display)
 {
@@ -22,6 +48,16 @@ Display *x_get_default_display()
     return default_display;
 }
 
+void x_mark_connection_lost()
+{
+    connection_lost = true;
+}
+
+bool x_is_connection_lost()
+{
+    return connection_lost;
+}
+
 Time x_get_current_time()
 {
     struct timeval now;
@@ -29,18 +65,237 @@ Time x_get_current_time()
     return (now.tv_sec * 1000) + (now.tv_usec / 1000);
 }
 
-void x_trap_errors(Display *display)
+XRoundTrip x_begin_round_trip(const char *function, const char *file, int line, bool always_counted)
 {
-    (void)display;
-    trapped_error_code = 0;
-    prev_error_handler = XSetErrorHandler(trap_error_handler);
+    XRoundTrip round_trip = {
+        .function = function,
+        .file = file,
+        .line = line,
+        .start_request = (default_display != NULL) ? NextRequest(default_display) : 0,
+        .always_counted = always_counted,
+        .start_ns = get_monotonic_time_ns(),
+        .span = begin_timeline_span("x11", function)
+    };
+    round_trip.span.file = file;
+    round_trip.span.line = line;
+    return round_trip;
+}
+
+void x_end_round_trip(XRoundTrip *round_trip)
+{
+    end_timeline_span(&round_trip->span);
+
+    // Ensure a request was actually issued, rather than answered from cache.
+    if (default_display == NULL) return;
+    if (!round_trip->always_counted &&
+        NextRequest(default_display) == round_trip->start_request) return;
+    uint64_t elapsed_ns = get_monotonic_time_ns() - round_trip->start_ns;
+
+    // Find the call site, adding it if it wasn't seen before.
+    XRoundTripSite *site = NULL;
+    for (int i = 0; i < round_trip_site_count; i++)
+    {
+        if (round_trip_sites[i].line == round_trip->line &&
+            round_trip_sites[i].file == round_trip->file)
+        {
+            site = &round_trip_sites[i];
+            break;
+        }
+    }
+    if (site == NULL && round_trip_site_count < X_MAX_ROUND_TRIP_SITES)
+    {
+        site = &round_trip_sites[round_trip_site_count++];
+        site->function = round_trip->function;
+        site->file = round_trip->file;
+        site->line = round_trip->line;
+    }
+
+    // Account for the round trip per call site and per event type.
+    if (site != NULL)
+    {
+        site->count++;
+        site->total_ns += elapsed_ns;
+    }
+    int event_type = get_dispatching_event_type();
+    XRoundTripTotals *totals = (event_type >= 0)
+        ? &round_trips_per_event_type[event_type]
+        : &round_trips_outside_handlers;
+    totals->count++;
+    totals->total_ns += elapsed_ns;
+    round_trips_total.count++;
+    round_trips_total.total_ns += elapsed_ns;
 }
 
-int x_untrap_errors(Display *display)
+static int compare_site_total_time(const void *a, const void *b)
 {
-    XSync(display, False);
-    XSetErrorHandler(prev_error_handler);
-    return trapped_error_code;
+    const XRoundTripSite *site_a = a;
+    const XRoundTripSite *site_b = b;
+    if (site_a->total_ns == site_b->total_ns) return 0;
+    return (site_a->total_ns < site_b->total_ns) ? 1 : -1;
+}
+
+void x_report_round_trips()
+{
+    // Print the round trips per call site, most expensive first.
+    XRoundTripSite sites[X_MAX_ROUND_TRIP_SITES];
+    memcpy(sites, round_trip_sites, round_trip_site_count * sizeof(XRoundTripSite));
+    qsort(sites, round_trip_site_count, sizeof(XRoundTripSite), compare_site_total_time);
+    fprintf(stderr, "%-28s %-32s %10s %12s\n", "REQUEST", "LOCATION", "COUNT", "BLOCKED (ms)");
+    for (int i = 0; i < round_trip_site_count; i++)
+    {
+        char location[COMMON_MAX_PATH_LENGTH];
+        snprintf(location, sizeof(location), "%s:%d", sites[i].file, sites[i].line);
+        fprintf(stderr,
+            "%-28s %-32s %10lu %12.3f\n",
+            sites[i].function, location,
+            sites[i].count, sites[i].total_ns / 1000000.0
+        );
+    }
+
+    // Print the round trips per event type being handled.
+    fprintf(stderr, "%-28s %10s %12s\n", "EVENT", "COUNT", "BLOCKED (ms)");
+    for (int type = 0; type < MAX_EVENT_TYPES; type++)
+    {
+        XRoundTripTotals *totals = &round_trips_per_event_type[type];
+        if (totals->count == 0) continue;
+        const char *name = get_event_type_name(type);
+        fprintf(stderr,
+            "%-28s %10lu %12.3f\n",
+            name != NULL ? name : "?", totals->count, totals->total_ns / 1000000.0
+        );
+    }
+    fprintf(stderr,
+        "%-28s %10lu %12.3f\n",
+        "(outside handlers)", round_trips_outside_handlers.count,
+        round_trips_outside_handlers.total_ns / 1000000.0
+    );
+    fprintf(stderr,
+        "%-28s %10lu %12.3f\n",
+        "total", round_trips_total.count, round_trips_total.total_ns / 1000000.0
+    );
+}
+
+int x_check_round_trip_budget(const char *path)
+{
+    // Open the budget file.
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return -1;
+
+    // Compare each budget against the accumulated round trips.
+    int status = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        // Parse the line, skipping empty lines and comments.
+        char name[128];
+        unsigned long budget;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %lu", name, &budget) != 2) continue;
+
+        // Find the amount of round trips the budget applies to.
+        unsigned long count = 0;
+        bool found = false;
+        if (strcmp(name, "total") == 0)
+        {
+            count = round_trips_total.count;
+            found = true;
+        }
+        for (int type = 0; type < MAX_EVENT_TYPES && !found; type++)
+        {
+            const char *type_name = get_event_type_name(type);
+            if (type_name == NULL || strcmp(type_name, name) != 0) continue;
+            count = round_trips_per_event_type[type].count;
+            found = true;
+        }
+        if (!found)
+        {
+            LOG_WARNING("Unknown round trip budget \"%s\".", name);
+            continue;
+        }
+
+        // Report the exceeded budget.
+        if (count > budget)
+        {
+            fprintf(stderr, "Round trip budget exceeded for %s (%lu > %lu).\n", name, count, budget);
+            status = -2;
+        }
+    }
+    fclose(file);
+
+    return status;
+}
+
+static void retire_error_ranges(Display *display)
+{
+    // Drop the ranges whose requests have all been processed by the server,
+    // any errors they caused have been handled by now.
+    unsigned long last_processed = LastKnownRequestProcessed(display);
+    while (error_range_count > 0 &&
+        error_ranges[error_range_head].last_request <= last_processed)
+    {
+        error_range_head = (error_range_head + 1) % X_MAX_ERROR_RANGES;
+        error_range_count--;
+    }
+}
+
+unsigned long x_begin_error_range(Display *display, XErrorCallback *callback, void *data)
+{
+    unsigned long first_request = NextRequest(display);
+
+    // Make room for the range, dropping the oldest range if necessary.
+    retire_error_ranges(display);
+    if (error_range_count >= X_MAX_ERROR_RANGES)
+    {
+        LOG_WARNING("Too many tracked error ranges, dropping the oldest one.");
+        error_range_head = (error_range_head + 1) % X_MAX_ERROR_RANGES;
+        error_range_count--;
+    }
+
+    // Track the range, open-ended until it is ended.
+    int index = (error_range_head + error_range_count) % X_MAX_ERROR_RANGES;
+    error_ranges[index] = (XErrorRange){
+        .first_request = first_request,
+        .last_request = ULONG_MAX,
+        .callback = callback,
+        .data = data
+    };
+    error_range_count++;
+
+    return first_request;
+}
+
+void x_end_error_range(Display *display, unsigned long first_request)
+{
+    // Find the most recent open range beginning at the given request.
+    for (int i = error_range_count - 1; i >= 0; i--)
+    {
+        XErrorRange *range = &error_ranges[(error_range_head + i) % X_MAX_ERROR_RANGES];
+        if (range->first_request != first_request) continue;
+        if (range->last_request != ULONG_MAX) continue;
+
+        // Close the range after the last request issued within it. A range
+        // without requests ends before it begins, and is retired right away.
+        range->last_request = NextRequest(display) - 1;
+        break;
+    }
+    retire_error_ranges(display);
+}
+
+bool x_handle_tracked_error(Display *display, XErrorEvent *error)
+{
+    // Match the most recent range first, as nested ranges are registered
+    // after the ranges enclosing them.
+    for (int i = error_range_count - 1; i >= 0; i--)
+    {
+        XErrorRange *range = &error_ranges[(error_range_head + i) % X_MAX_ERROR_RANGES];
+        if (error->serial < range->first_request) continue;
+        if (error->serial > range->last_request) continue;
+
+        // Pass the error to the callback of the range, if any.
+        if (range->callback != NULL) range->callback(display, error, range->data);
+        return true;
+    }
+    return false;
 }
 
 pid_t x_get_window_pid(Display *display, Window window)
@@ -48,8 +303,8 @@ pid_t x_get_window_pid(Display *display, Window window)
     // Retrieve the `_NET_WM_PID` property from the window.
     unsigned char *data;
     unsigned long item_count;
-    Atom _NET_WM_PID = XInternAtom(display, "_NET_WM_PID", False);
-    int status = XGetWindowProperty(
+    Atom _NET_WM_PID = ATOM(_NET_WM_PID);
+    int status = X_ROUND_TRIP(XGetWindowProperty,
         display,                // Display
         window,                 // Window
         _NET_WM_PID,            // Property
@@ -73,28 +328,19 @@ pid_t x_get_window_pid(Display *display, Window window)
     return pid;
 }
 
-Window x_get_window_parent(Display *display, Window window)
-{
-    Window parent, *children;
-    int status = XQueryTree(display, window, &(Window){0}, &parent, &children, &(unsigned int){0});
-    if (status == 0) return None;
-    XFree(children);
-    return parent;
-}
-
 int x_get_window_name(Display *display, Window window, char *out_name, size_t name_size)
 {
     // List of properties to check for the window name.
     const int property_count = 2;
     Atom properties[property_count];
-    properties[0] = XInternAtom(display, "_NET_WM_NAME", False);
-    properties[1] = XInternAtom(display, "WM_NAME", False);
+    properties[0] = ATOM(_NET_WM_NAME);
+    properties[1] = ATOM(WM_NAME);
 
     // Loop over the properties, and stores the first one that is available.
     unsigned char *name = NULL;
     for(int i = 0; i < property_count; i++)
     {
-        int status = XGetWindowProperty(
+        int status = X_ROUND_TRIP(XGetWindowProperty,
             display,                // Display
             window,                 // Window
             properties[i],          // Property
@@ -124,7 +370,7 @@ bool x_window_supports_protocol(Display *display, Window window, Atom protocol)
 {
     Atom *protocols;
     int count;
-    if (XGetWMProtocols(display, window, &protocols, &count))
+    if (X_ROUND_TRIP(XGetWMProtocols, display, window, &protocols, &count))
     {
         for (int i = 0; i < count; i++)
         {
@@ -139,11 +385,6 @@ bool x_window_supports_protocol(Display *display, Window window, Atom protocol)
     return False;
 }
 
-bool x_window_exists(Display *display, Window window)
-{
-    return XGetWindowAttributes(display, window, &(XWindowAttributes){0}) != 0;
-}
-
 unsigned int x_keysym_to_modifier(KeySym keysym)
 {
     switch (keysym)
@@ -277,108 +518,6 @@ int x_key_names_to_symbols(char *names, const char delimiter, int *out_keys, int
     return status;
 }
 
-static int _x_query_tree_recursively(
-    Display *display,
-    Window parent,
-    Window **out_children,
-    unsigned int *out_children_count,
-    int *out_current_position
-)
-{
-    // Query the children of the parent.
-    Window *children = NULL;
-    unsigned int children_count = 0;
-    if (XQueryTree(display, parent, &(Window){0}, &(Window){0}, &children, &children_count) == 0)
-    {
-        // Removing this window from the out_children array, as the query 
-        // failed. This is most likely because the window was destroyed.
-        if (*out_children != NULL && *out_children_count > 0 && *out_current_position > 0)
-        {
-            (*out_current_position)--;
-            (*out_children_count)--;
-            (*out_children)[*out_current_position] = None;
-        }
-        return 0;
-    }
-
-    // Ensure we don't handle parents without children.
-    if (children_count == 0) return 0;
-
-    // Increase the output children count and reallocate memory for them.
-    *out_children_count += children_count;
-    Window *new_out_children = realloc(*out_children, (*out_children_count) * sizeof(Window));
-    if (new_out_children == NULL)
-    {
-        *out_children_count -= children_count;
-        XFree(children);
-        return -1;
-    }
-    *out_children = new_out_children;
-
-    // Iterate over each child from the tree query.
-    for (unsigned int i = 0; i < children_count; i++) {
-        // Insert this child into the children output.
-        (*out_children)[*out_current_position] = children[i];
-        (*out_current_position)++;
-
-        // Insert its children into the children output.
-        int status = _x_query_tree_recursively(display, children[i], out_children, out_children_count, out_current_position);
-        if (status != 0)
-        {
-            XFree(children);
-            return status;
-        }
-    }
-
-    XFree(children);
-    return 0;
-}
-
-int x_query_tree_recursively(Display *display, Window parent, Window **out_children, unsigned int *out_children_count)
-{
-    // Initialize the required variables.
-    *out_children = NULL;
-    *out_children_count = 0;
-    int current_position = 0;
-
-    // Recursively query the tree.
-    int status = _x_query_tree_recursively(display, parent, out_children, out_children_count, &current_position);
-    if (status != 0)
-    {
-        free(*out_children);
-        *out_children = NULL;
-        *out_children_count = 0;
-    }
-    return status;
-}
-
-bool x_window_is_top_level(Display *display, Window window)
-{
-    Window root_window = DefaultRootWindow(display);
-
-    // Retrieve the parent window of the provided window.
-    Window parent_window = x_get_window_parent(display, window);
-
-    // Retrieve the attributes of the provided window.
-    XWindowAttributes attributes;
-    if (XGetWindowAttributes(display, window, &attributes) == 0)
-    {
-        LOG_WARNING(
-            "Could not determine whether window (0x%lx) is top-level, window "
-            "attributes unavailable. Falling back to 'false' (Not top-level).",
-            window
-        );
-        return false;
-    }
-
-    // Determine if window is a top-level window.
-    if (parent_window == root_window && attributes.override_redirect == False)
-    {
-        return true;
-    }
-    return false;
-}
-
 Window x_create_simple_window(
     Display *display,
     Window parent,
@@ -404,7 +543,7 @@ Window x_create_simple_window(
 
     // Assign the `_NET_WM_PID` property to the window.
     pid_t pid = getpid();
-    Atom _NET_WM_PID = XInternAtom(display, "_NET_WM_PID", False);
+    Atom _NET_WM_PID = ATOM(_NET_WM_PID);
     XChangeProperty(
         display,                // Display
         window,                 // Window
@@ -424,7 +563,7 @@ Window x_create_simple_window(
 
 void x_set_wm_state(Display *display, Window window, unsigned long state)
 {
-    Atom WM_STATE = XInternAtom(display, "WM_STATE", False);
+    Atom WM_STATE = ATOM(WM_STATE);
     unsigned long state_data[2] = {
         state,  // WM state (e.g. WithdrawnState, NormalState, IconicState)
         None    // Icon window (none)
@@ -441,70 +580,10 @@ void x_set_wm_state(Display *display, Window window, unsigned long state)
     );
 }
 
-int x_get_transient_for(Display *display, Window window, Window *out_transient_for)
-{
-    Window transient_for = None;
-
-    // Query the WM_TRANSIENT_FOR property.
-    if (XGetTransientForHint(display, window, &transient_for) == 0)
-    {
-        return -1;  // No transient-for hint set.
-    }
-
-    if (transient_for == None)
-    {
-        return -1;  // Transient-for hint is None.
-    }
-
-    *out_transient_for = transient_for;
-    return 0;
-}
-
-bool x_window_wants_decorations_motif(Display *display, Window window)
-{
-    // Retrieve the `_MOTIF_WM_HINTS` property from the window.
-    unsigned char *data = NULL;
-    unsigned long nitems;
-    Atom _MOTIF_WM_HINTS = XInternAtom(display, "_MOTIF_WM_HINTS", False);
-    int status = XGetWindowProperty(
-        display,            // Display
-        window,             // Window
-        _MOTIF_WM_HINTS,    // Property
-        0, 5,               // Offset, length
-        False,              // Delete
-        AnyPropertyType,    // Type
-        &(Atom){0},         // Actual type (unused)
-        &(int){0},          // Actual format (unused)
-        &nitems,            // Item count
-        &(unsigned long){0},// Bytes after (unused)
-        &data               // Data
-    );
-    if (status != Success || data == NULL || nitems < 3)
-    {
-        if (data != NULL) XFree(data);
-        return true;
-    }
-
-    // Extract the flags and decorations fields from the hints structure.
-    unsigned long *hints = (unsigned long *)data;
-    unsigned long flags = hints[0];
-    unsigned long decorations = hints[2];
-
-    // Free the property data.
-    XFree(data);
-
-    // Check if the decorations hint is set and requests no decorations.
-    // MWM_HINTS_DECORATIONS = (1 << 1)
-    if ((flags & (1 << 1)) && decorations == 0)
-    {
-        return false;
-    }
-
-    return true;
-}
-
 bool x_window_wants_decorations_ewmh(Display *display, Atom window_type)
 {
+    (void)display;
+
     // Return true if no window type is set.
     if (window_type == None)
     {
@@ -512,10 +591,10 @@ bool x_window_wants_decorations_ewmh(Display *display, Atom window_type)
     }
 
     // Check if the window type is one that should not have decorations.
-    Atom _NET_WM_WINDOW_TYPE_DOCK = XInternAtom(display, "_NET_WM_WINDOW_TYPE_DOCK", False);
-    Atom _NET_WM_WINDOW_TYPE_SPLASH = XInternAtom(display, "_NET_WM_WINDOW_TYPE_SPLASH", False);
-    Atom _NET_WM_WINDOW_TYPE_TOOLTIP = XInternAtom(display, "_NET_WM_WINDOW_TYPE_TOOLTIP", False);
-    Atom _NET_WM_WINDOW_TYPE_NOTIFICATION = XInternAtom(display, "_NET_WM_WINDOW_TYPE_NOTIFICATION", False);
+    Atom _NET_WM_WINDOW_TYPE_DOCK = ATOM(_NET_WM_WINDOW_TYPE_DOCK);
+    Atom _NET_WM_WINDOW_TYPE_SPLASH = ATOM(_NET_WM_WINDOW_TYPE_SPLASH);
+    Atom _NET_WM_WINDOW_TYPE_TOOLTIP = ATOM(_NET_WM_WINDOW_TYPE_TOOLTIP);
+    Atom _NET_WM_WINDOW_TYPE_NOTIFICATION = ATOM(_NET_WM_WINDOW_TYPE_NOTIFICATION);
     if (window_type == _NET_WM_WINDOW_TYPE_DOCK ||
         window_type == _NET_WM_WINDOW_TYPE_SPLASH ||
         window_type == _NET_WM_WINDOW_TYPE_TOOLTIP ||
@@ -527,81 +606,11 @@ bool x_window_wants_decorations_ewmh(Display *display, Atom window_type)
     return true;
 }
 
-Atom x_get_window_type(Display *display, Window window)
-{
-    Atom _NET_WM_WINDOW_TYPE = XInternAtom(display, "_NET_WM_WINDOW_TYPE", False);
-    Atom _NET_WM_WINDOW_TYPE_NORMAL = XInternAtom(display, "_NET_WM_WINDOW_TYPE_NORMAL", False);
-
-    // Query the _NET_WM_WINDOW_TYPE property.
-    Atom actual_type;
-    int actual_format;
-    unsigned long nitems, bytes_after;
-    unsigned char *data = NULL;
-    int status = XGetWindowProperty(
-        display,
-        window,
-        _NET_WM_WINDOW_TYPE,
-        0, 1,
-        False,
-        XA_ATOM,
-        &actual_type,
-        &actual_format,
-        &nitems,
-        &bytes_after,
-        &data
-    );
-    if (status != Success || data == NULL || nitems == 0)
-    {
-        if (data != NULL) XFree(data);
-        return _NET_WM_WINDOW_TYPE_NORMAL;
-    }
-
-    // Return the first atom in the list.
-    Atom window_type = *(Atom *)data;
-    XFree(data);
-
-    return window_type;
-}
-
-int x_get_window_desktop(Display *display, Window window)
-{
-    // Retrieve the `_NET_WM_DESKTOP` property from the window.
-    unsigned char *data;
-    unsigned long item_count;
-    Atom _NET_WM_DESKTOP = XInternAtom(display, "_NET_WM_DESKTOP", False);
-    int status = XGetWindowProperty(
-        display,                // Display
-        window,                 // Window
-        _NET_WM_DESKTOP,        // Property
-        0, 1,                   // Offset, length
-        False,                  // Delete
-        XA_CARDINAL,            // Type
-        &(Atom){0},             // Response type (unused)
-        &(int){0},              // Response format (unused)
-        &item_count,            // Item count
-        &(unsigned long){0},    // Bytes after (unused)
-        &data                   // Data
-    );
-    if (status != Success || data == NULL || item_count != 1)
-    {
-        if (data != NULL) XFree(data);
-        return -1;
-    }
-
-    // Store the desktop index, so we can free the property data.
-    int desktop = (int)*(uint32_t*)data;
-
-    // Free the property data.
-    XFree(data);
-
-    return desktop;
-}
-
 bool x_focus_window(Display *display, Window window)
 {
     // Verify the window is viewable before setting focus.
     XWindowAttributes attrs;
-    if (!XGetWindowAttributes(display, window, &attrs)) return false;
+    if (!X_ROUND_TRIP(XGetWindowAttributes, display, window, &attrs)) return false;
     if (attrs.map_state != IsViewable) return false;
 
     XSetInputFocus(display, window, RevertToPointerRoot, CurrentTime);
@@ -624,7 +633,7 @@ int x_get_window_class(Display *display, Window window, char *out_buffer, size_t
 {
     // Retrieve the `WM_CLASS` property using `XGetClassHint()`.
     XClassHint class_hint;
-    if (XGetClassHint(display, window, &class_hint) == 0)
+    if (X_ROUND_TRIP(XGetClassHint, display, window, &class_hint) == 0)
     {
         return -1;
     }
@@ -650,7 +659,7 @@ int x_get_window_class(Display *display, Window window, char *out_buffer, size_t
 float x_average_luminance(Display *display, Pixmap pixmap, int x, int y, int width, int height)
 {
     // Acquire the region from the pixmap.
-    XImage *image = XGetImage(
+    XImage *image = X_ROUND_TRIP(XGetImage,
         display, pixmap, x, y, width, height, AllPlanes, ZPixmap
     );
     if (!image) return -1.0f;
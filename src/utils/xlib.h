@@ -6,6 +6,114 @@
  */
 #define DefaultDisplay x_get_default_display()
 
+/** The maximum number of distinct call sites tracked by the round trip layer. */
+#define X_MAX_ROUND_TRIP_SITES 256
+
+/**
+ * A synchronous Xlib call in progress, see `X_ROUND_TRIP()`.
+ */
+typedef struct {
+    const char *function;
+    const char *file;
+    int line;
+    unsigned long start_request;
+    bool always_counted;             // Whether issued outside of Xlib.
+    uint64_t start_ns;
+    TimelineSpan span;
+} XRoundTrip;
+
+/**
+ * Performs a synchronous (round trip) Xlib call through the round trip
+ * accounting layer, which counts the round trip and the time spent blocked,
+ * per call site and per event type being handled, and records it as a span on
+ * the timeline.
+ * 
+ * @param function The Xlib function (E.g. `XGetWindowAttributes`).
+ * @param ... The arguments of the Xlib function.
+ * 
+ * @return The return value of the Xlib function.
+ * 
+ * @note - Usage: `X_ROUND_TRIP(XSync, display, False)`.
+ * @note - Every synchronous Xlib call should be made through this macro.
+ */
+#define X_ROUND_TRIP(function, ...) ({ \
+    XRoundTrip _round_trip = x_begin_round_trip(#function, __FILE__, __LINE__, false); \
+    __typeof__(function(__VA_ARGS__)) _round_trip_result = function(__VA_ARGS__); \
+    x_end_round_trip(&_round_trip); \
+    _round_trip_result; \
+})
+
+/**
+ * Waits for the replies to requests issued through the XCB connection
+ * underlying Xlib, through the round trip accounting layer, see
+ * `X_ROUND_TRIP()`.
+ * 
+ * @param function The function collecting the replies.
+ * @param ... The arguments of the function.
+ * 
+ * @return The return value of the function.
+ * 
+ * @note - Requests issued through XCB don't advance the request counter of
+ * Xlib, so the wait is always counted as a round trip.
+ */
+#define X_REPLY_ROUND_TRIP(function, ...) ({ \
+    XRoundTrip _round_trip = x_begin_round_trip(#function, __FILE__, __LINE__, true); \
+    __typeof__(function(__VA_ARGS__)) _round_trip_result = function(__VA_ARGS__); \
+    x_end_round_trip(&_round_trip); \
+    _round_trip_result; \
+})
+
+/**
+ * Begins accounting for a synchronous Xlib call.
+ * 
+ * @param function The name of the Xlib function.
+ * @param file The source file of the call site.
+ * @param line The source line of the call site.
+ * @param always_counted Whether to count the call even if Xlib issued no
+ * request.
+ * 
+ * @return - `XRoundTrip` - The round trip in progress.
+ * 
+ * @warning - Don't use directly! Use the `X_ROUND_TRIP()` macro instead.
+ */
+XRoundTrip x_begin_round_trip(const char *function, const char *file, int line, bool always_counted);
+
+/**
+ * Ends accounting for a synchronous Xlib call.
+ * 
+ * @param round_trip The round trip in progress.
+ * 
+ * @note - Calls that were answered from a client-side cache (E.g. interned 
+ * atoms) issue no request, and are not counted as round trips.
+ * 
+ * @warning - Don't use directly! Use the `X_ROUND_TRIP()` macro instead.
+ */
+void x_end_round_trip(XRoundTrip *round_trip);
+
+/**
+ * Prints the accumulated round trips to `stderr`, per call site and per event
+ * type being handled, sorted by the time spent blocked.
+ * 
+ * @note - The report is printed alongside the event handler profile, at exit
+ * and when the window manager receives `SIGUSR1`.
+ */
+void x_report_round_trips();
+
+/**
+ * Compares the accumulated round trips against a budget file.
+ * 
+ * Each line of the budget file holds an event type name (E.g.
+ * `ConfigureNotify`), or `total`, followed by the maximum number of round
+ * trips. Empty lines and lines starting with `#` are ignored.
+ * 
+ * @param path The path of the budget file.
+ * 
+ * @return - `0` - The round trips are within the budget.
+ * @return - `-1` - The budget file could not be opened.
+ * @return - `-2` - One or more budgets were exceeded.
+ */
+int x_check_round_trip_budget(const char *path);
+
 /**
  * Sets the default X11 display for global access across the codebase.
  * 
@@ -29,6 +137,22 @@ void x_set_default_display(Display *display);
  */
 Display *x_get_default_display();
 
+/**
+ * Marks the connection to the X server as lost, see `x_is_connection_lost()`.
+ *
+ * @warning - Should only be called from the X11 I/O error handler.
+ */
+void x_mark_connection_lost();
+
+/**
+ * Checks whether the connection to the X server was lost, after which no
+ * further requests may be issued.
+ *
+ * @return - `true` A fatal I/O error occurred.
+ * @return - `false` The connection is still usable.
+ */
+bool x_is_connection_lost();
+
 /**
  * Retrieves the current time.
  * 
@@ -36,29 +160,61 @@ Display *x_get_default_display();
  */
 Time x_get_current_time();
 
+/** The maximum number of request ranges tracked for errors at once. */
+#define X_MAX_ERROR_RANGES 256
+
 /**
- * Begins trapping X11 errors on the given display.
- *
- * While a trap is active, errors are silently recorded instead of being
- * passed to the normal error handler. Call `x_untrap_errors` to end the
- * trap, flush pending errors via `XSync`, and retrieve the error code.
- *
+ * Error callback function signature, see `x_begin_error_range()`.
+ * 
  * @param display The X11 display.
- *
- * @warning Not reentrant. Only one trap may be active at a time.
+ * @param error The error caused by a request within the range.
+ * @param data The user data passed during registration.
  */
-void x_trap_errors(Display *display);
+typedef void XErrorCallback(Display *display, XErrorEvent *error, void *data);
 
 /**
- * Ends an active error trap, syncs with the server, and returns the
- * trapped error code (or 0 if no error occurred).
- *
+ * Begins a range of requests whose errors are tracked asynchronously.
+ * 
+ * Errors caused by requests within the range are matched by sequence number 
+ * as they arrive in the normal event flow, and passed to the callback instead
+ * of the normal error handler. Unlike trapping errors with `XSync`, this never
+ * forces a round trip. The range is open until `x_end_error_range()` is
+ * called, so errors reported by round trips within the range are matched too.
+ * Nested ranges take precedence over the ranges enclosing them.
+ * 
  * @param display The X11 display.
- *
- * @return - `0` - No error occurred during the trap.
- * @return - `> 0` - The X11 error code of the first trapped error.
+ * @param callback The callback function, or `NULL` to silently ignore errors.
+ * @param data The user data to pass to the callback function.
+ * 
+ * @return - `unsigned long` - The sequence number of the first request within
+ * the range, to be passed to `x_end_error_range()`.
+ * 
+ * @note - The callback may be called after the range has ended, possibly
+ * during the dispatch of an unrelated event.
+ */
+unsigned long x_begin_error_range(Display *display, XErrorCallback *callback, void *data);
+
+/**
+ * Ends a range of requests whose errors are tracked asynchronously, errors
+ * caused by the requests issued within the range are still matched afterwards.
+ * 
+ * @param display The X11 display.
+ * @param first_request The value returned by `x_begin_error_range()`.
+ */
+void x_end_error_range(Display *display, unsigned long first_request);
+
+/**
+ * Passes an error to the callback of the tracked range it belongs to.
+ * 
+ * @param display The X11 display.
+ * @param error The error to handle.
+ * 
+ * @return - `true` - The error belonged to a tracked range, and was handled.
+ * @return - `false` - The error didn't belong to any tracked range.
+ * 
+ * @warning - Should only be called from the X11 error handler.
  */
-int x_untrap_errors(Display *display);
+bool x_handle_tracked_error(Display *display, XErrorEvent *error);
 
 /**
  * Retrieves the process ID of the X client that owns the window.
@@ -75,17 +231,6 @@ int x_untrap_errors(Display *display);
  */
 pid_t x_get_window_pid(Display *display, Window window);
 
-/**
- * Retrieves the parent window of a given window.
- * 
- * @param display The X11 display.
- * @param window The target window.
- * 
- * @return - `Window` - The parent window.
- * @return - `0` - The parent window could not be retrieved.
- */
-Window x_get_window_parent(Display *display, Window window);
-
 /**
  * Retrieves the name of an X11 window.
  * 
@@ -111,17 +256,6 @@ int x_get_window_name(Display *display, Window window, char *out_name, size_t na
  */
 bool x_window_supports_protocol(Display *display, Window window, Atom protocol);
 
-/**
- * Checks if a window exists.
- * 
- * @param display The X11 display.
- * @param window The window to check.
- * 
- * @return - `true` - The window exists.
- * @return - `false` - The window does not exist.
- */
-bool x_window_exists(Display *display, Window window);
-
 /**
  * Converts a keysym to its corresponding X11 modifier mask.
  *
@@ -163,36 +297,6 @@ int x_key_name_to_symbol(const char *name, int *out_key);
  */
 int x_key_names_to_symbols(char *names, const char delimiter, int *out_keys, int keys_size);
 
-/**
- * Queries the children of a window recursively.
- * 
- * @param display The X11 display.
- * @param parent The parent window.
- * @param out_children The buffer where the children will be stored.
- * @param out_children_count The buffer where the children count will be stored.
- * 
- * @return - `0` - The query was completed succesfully.
- * @return - `-1` - The query failed, memory allocation error.
- * 
- * @warning - Recursive X server calls make this function slow and 
- * resource-intensive.
- */
-int x_query_tree_recursively(Display *display, Window parent, Window **out_children, unsigned int *out_children_count);
-
-/**
- * Checks if a window is a top-level window.
- * 
- * A top-level window, according to the ICCCM standard, is a window that has the
- * root window as its parent and is not an override-redirect window.
- * 
- * @param display The X11 display.
- * @param window The window to check.
- * 
- * @return - `true` - The window is a top-level window.
- * @return - `false` - The window is not a top-level window.
- */
-bool x_window_is_top_level(Display *display, Window window);
-
 /**
  * A wrapper of the `XCreateSimpleWindow()` Xlib function, with some minor
  * additional functionality.
@@ -232,32 +336,6 @@ Window x_create_simple_window(
  */
 void x_set_wm_state(Display *display, Window window, unsigned long state);
 
-/**
- * Retrieves the transient-for window hint for a given window.
- *
- * @param display The X11 display.
- * @param window The window to query.
- * @param out_transient_for Pointer to store the transient-for window.
- *
- * @return - `0` - Success, the window is transient for another window.
- * @return - `-1` - The window is not transient (no WM_TRANSIENT_FOR hint).
- *
- * @note - Per ICCCM, transient windows (dialogs, popups) should be stacked
- * above their parent window.
- */
-int x_get_transient_for(Display *display, Window window, Window *out_transient_for);
-
-/**
- * Checks if a window wants decorations based on _MOTIF_WM_HINTS.
- *
- * @param display The X11 display.
- * @param window The window to query.
- *
- * @return - `true` - The window wants decorations (or no hint set).
- * @return - `false` - The window explicitly requests no decorations.
- */
-bool x_window_wants_decorations_motif(Display *display, Window window);
-
 /**
  * Checks if a window wants decorations based on EWMH _NET_WM_WINDOW_TYPE.
  *
@@ -269,28 +347,6 @@ bool x_window_wants_decorations_motif(Display *display, Window window);
  */
 bool x_window_wants_decorations_ewmh(Display *display, Atom window_type);
 
-/**
- * Retrieves the window type from the _NET_WM_WINDOW_TYPE property.
- *
- * @param display The X11 display.
- * @param window The window to query.
- *
- * @return - The first atom from _NET_WM_WINDOW_TYPE property.
- * @return - _NET_WM_WINDOW_TYPE_NORMAL if the property is not set.
- */
-Atom x_get_window_type(Display *display, Window window);
-
-/**
- * Retrieves the workspace index from the _NET_WM_DESKTOP property.
- *
- * @param display The X11 display.
- * @param window The target window.
- *
- * @return - `>= 0` - The workspace index.
- * @return - `-1` - The property is not set or could not be read.
- */
-int x_get_window_desktop(Display *display, Window window);
-
 /**
  * Sets input focus to a window, but only if it is currently viewable.
  *
@@ -6,18 +6,45 @@
 
 #include "../all.h"
 
-/** The tile order list for each workspace. */
-static Portal *tile_order[MAX_WORKSPACES][MAX_WORKSPACE_PORTALS] = {{NULL}};
+/** The tile order list for each workspace, grown as needed. */
+static Portal **tile_order[MAX_WORKSPACES] = {NULL};
+static int tile_order_capacity[MAX_WORKSPACES] = {0};
 
 /** The number of portals in the tile order for each workspace. */
 static int tile_order_count[MAX_WORKSPACES] = {0};
 
+/** The tile geometries computed by the last layout, grown as needed. */
+static PortalGeometry *tile_geometries = NULL;
+static int tile_geometries_capacity = 0;
+
 /** The gap between tiled portals in pixels. */
 static int tile_gap = 0;
 
 /** Reentrancy guard for `apply_tiling_layout()`. */
 static bool applying_layout = false;
 
+/**
+ * Ensures a growable array can hold at least `count` elements, doubling its
+ * capacity if it can't.
+ *
+ * @return - `0` The array can hold the elements.
+ * @return - `-1` Memory allocation failed.
+ */
+static int ensure_tile_capacity(void *array, int *capacity, int count, size_t element_size)
+{
+    if (count <= *capacity) return 0;
+
+    // Double the capacity until the elements fit.
+    int new_capacity = (*capacity > 0) ? *capacity : 8;
+    while (new_capacity < count) new_capacity *= 2;
+    void *new_array = realloc(*(void **)array, new_capacity * element_size);
+    if (new_array == NULL) return -1;
+
+    *(void **)array = new_array;
+    *capacity = new_capacity;
+    return 0;
+}
+
 bool is_tiling_eligible(Portal *portal)
 {
     if (!portal->active) return false;
@@ -56,7 +83,13 @@ void remove_from_tile_order(Portal *portal, int workspace)
 void append_to_tile_order(Portal *portal, int workspace)
 {
     if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
-    if (tile_order_count[workspace] >= MAX_WORKSPACE_PORTALS) return;
+    insert_into_tile_order(portal, workspace, tile_order_count[workspace]);
+}
+
+void insert_into_tile_order(Portal *portal, int workspace, int position)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
+    if (tile_order_count[workspace] >= get_workspace_capacity()) return;
 
     // Ensure portal is not already in tile order.
     for (int i = 0; i < tile_order_count[workspace]; i++)
@@ -64,8 +97,24 @@ void append_to_tile_order(Portal *portal, int workspace)
         if (tile_order[workspace][i] == portal) return;
     }
 
-    // Append the portal.
-    tile_order[workspace][tile_order_count[workspace]] = portal;
+    // Ensure the tile order can hold another portal.
+    if (ensure_tile_capacity(&tile_order[workspace], &tile_order_capacity[workspace],
+        tile_order_count[workspace] + 1, sizeof(Portal *)) != 0)
+    {
+        LOG_ERROR("Could not add portal to tile order, memory allocation failed.");
+        return;
+    }
+
+    // Shift subsequent entries backward to open a gap.
+    if (position < 0) position = 0;
+    if (position > tile_order_count[workspace]) position = tile_order_count[workspace];
+    for (int i = tile_order_count[workspace]; i > position; i--)
+    {
+        tile_order[workspace][i] = tile_order[workspace][i - 1];
+    }
+
+    // Insert the portal.
+    tile_order[workspace][position] = portal;
     tile_order_count[workspace]++;
 }
 
@@ -75,6 +124,17 @@ int get_tile_order_count(int workspace)
     return tile_order_count[workspace];
 }
 
+Portal **get_tile_order(int workspace, int *out_count)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES)
+    {
+        *out_count = 0;
+        return NULL;
+    }
+    *out_count = tile_order_count[workspace];
+    return tile_order[workspace];
+}
+
 void clear_tile_order(int workspace)
 {
     if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
@@ -86,151 +146,186 @@ void clear_tile_order(int workspace)
 }
 
 /**
- * Computes tile geometry for a portal at the given index in a layout
- * of `count` portals. Pure function of count, index, viewport, and gap.
+ * Determines the number of rows of a balanced grid of `count` tiles, such
+ * that the tiles best match the aspect ratio of the viewport. This is the
+ * rounded square root of `count * viewport_height / viewport_width`, computed
+ * in integers.
  */
-static PortalGeometry calc_tile_geometry(
-    int count, int index,
-    int viewport_width, int viewport_height, int gap
+static int calc_tile_rows(int count, int viewport_width, int viewport_height)
+{
+    // Increment the rows while `(rows + 0.5)^2 <= count * height / width`.
+    int rows = 0;
+    while (rows < count &&
+        (int64_t)(2 * rows + 1) * (2 * rows + 1) * viewport_width <=
+        (int64_t)4 * count * viewport_height)
+    {
+        rows++;
+    }
+    return common.int_max(rows, 1);
+}
+
+/**
+ * Computes the tile geometries of a layout of `count` portals in a single
+ * pass. Tiles are arranged in a balanced grid whose rows are filled top to
+ * bottom, with the bottom rows taking one extra column if the count doesn't
+ * divide evenly. Three tiles that would share a single row use a master/stack
+ * layout instead, as the fixed layout table did: the first tile takes the left
+ * half, the others are stacked in the right half. Larger counts on a wide
+ * viewport keep their single row, rather than stacking into slivers.
+ */
+static void calc_tile_geometries(
+    int count,
+    int viewport_width, int viewport_height, int gap,
+    PortalGeometry *out_geometries
 )
 {
-    PortalGeometry geometry = {0, 0, 0, 0};
-    int usable_width = viewport_width;
-    int usable_height = viewport_height;
+    if (count <= 0) return;
+    int rows = calc_tile_rows(count, viewport_width, viewport_height);
 
-    switch (count)
+    // Master/stack layout.
+    if (rows == 1 && count == 3)
     {
-        case 1:
+        int col_width = common.int_max(1, (viewport_width - 3 * gap) / 2);
+        int stack_count = count - 1;
+        int row_height = common.int_max(1, (viewport_height - (stack_count + 1) * gap) / stack_count);
+        out_geometries[0] = (PortalGeometry){
+            gap, gap, col_width, common.int_max(1, viewport_height - 2 * gap)
+        };
+        for (int i = 1; i < count; i++)
         {
-            // Single portal fills the full viewport minus gap.
-            geometry.x_root = gap;
-            geometry.y_root = gap;
-            geometry.width = usable_width - 2 * gap;
-            geometry.height = usable_height - 2 * gap;
-            break;
-        }
-        case 2:
-        {
-            // Two equal columns, each full height.
-            int col_width = (usable_width - 3 * gap) / 2;
-            geometry.x_root = gap + index * (col_width + gap);
-            geometry.y_root = gap;
-            geometry.width = col_width;
-            geometry.height = usable_height - 2 * gap;
-            break;
+            out_geometries[i] = (PortalGeometry){
+                gap + col_width + gap,
+                gap + (i - 1) * (row_height + gap),
+                col_width, row_height
+            };
         }
-        case 3:
-        {
-            // Left column full height, right column split into two rows.
-            int col_width = (usable_width - 3 * gap) / 2;
-            if (index == 0)
-            {
-                geometry.x_root = gap;
-                geometry.y_root = gap;
-                geometry.width = col_width;
-                geometry.height = usable_height - 2 * gap;
-            }
-            else
-            {
-                int row_height = (usable_height - 3 * gap) / 2;
-                int row = index - 1;
-                geometry.x_root = gap + col_width + gap;
-                geometry.y_root = gap + row * (row_height + gap);
-                geometry.width = col_width;
-                geometry.height = row_height;
-            }
-            break;
-        }
-        case 4:
-        {
-            // 2x2 grid of equal quadrants.
-            int col_width = (usable_width - 3 * gap) / 2;
-            int row_height = (usable_height - 3 * gap) / 2;
-            int row = index / 2;
-            int col = index % 2;
-            geometry.x_root = gap + col * (col_width + gap);
-            geometry.y_root = gap + row * (row_height + gap);
-            geometry.width = col_width;
-            geometry.height = row_height;
-            break;
-        }
-        case 5:
+        return;
+    }
+
+    // Balanced grid layout.
+    int row_height = common.int_max(1, (viewport_height - (rows + 1) * gap) / rows);
+    int narrow_columns = count / rows;
+    int first_wide_row = rows - count % rows;
+    int row = 0, column = 0;
+    int columns = (row >= first_wide_row) ? narrow_columns + 1 : narrow_columns;
+    int col_width = common.int_max(1, (viewport_width - (columns + 1) * gap) / columns);
+    for (int i = 0; i < count; i++)
+    {
+        out_geometries[i] = (PortalGeometry){
+            gap + column * (col_width + gap),
+            gap + row * (row_height + gap),
+            col_width, row_height
+        };
+
+        // Advance to the next row once this one is full.
+        if (++column == columns && i + 1 < count)
         {
-            // Top row: 2 columns. Bottom row: 3 columns.
-            int row_height = (usable_height - 3 * gap) / 2;
-            if (index < 2)
-            {
-                int col_width = (usable_width - 3 * gap) / 2;
-                geometry.x_root = gap + index * (col_width + gap);
-                geometry.y_root = gap;
-                geometry.width = col_width;
-                geometry.height = row_height;
-            }
-            else
-            {
-                int col_width = (usable_width - 4 * gap) / 3;
-                int col = index - 2;
-                geometry.x_root = gap + col * (col_width + gap);
-                geometry.y_root = gap + row_height + gap;
-                geometry.width = col_width;
-                geometry.height = row_height;
-            }
-            break;
+            row++;
+            column = 0;
+            columns = (row >= first_wide_row) ? narrow_columns + 1 : narrow_columns;
+            col_width = common.int_max(1, (viewport_width - (columns + 1) * gap) / columns);
         }
-        case 6:
+    }
+}
+
+/**
+ * The layouts of the fixed layout table that preceded `calc_tile_geometries()`,
+ * as the number of columns of each row, for 1 to 8 tiles. The table laid out 3
+ * tiles as master/stack.
+ */
+static const int legacy_tile_columns[9][2] = {
+    {0, 0}, {1, 0}, {2, 0}, {0, 0}, {2, 2}, {2, 3}, {3, 3}, {3, 4}, {4, 4}
+};
+
+/** Computes the tile geometries the fixed layout table produced. */
+static void calc_legacy_tile_geometries(
+    int count,
+    int viewport_width, int viewport_height, int gap,
+    PortalGeometry *out_geometries
+)
+{
+    // Master/stack layout.
+    if (count == 3)
+    {
+        int col_width = (viewport_width - 3 * gap) / 2;
+        int row_height = (viewport_height - 3 * gap) / 2;
+        out_geometries[0] = (PortalGeometry){gap, gap, col_width, viewport_height - 2 * gap};
+        out_geometries[1] = (PortalGeometry){2 * gap + col_width, gap, col_width, row_height};
+        out_geometries[2] = (PortalGeometry){
+            2 * gap + col_width, 2 * gap + row_height, col_width, row_height
+        };
+        return;
+    }
+
+    // Grid layout.
+    int rows = (legacy_tile_columns[count][1] > 0) ? 2 : 1;
+    int row_height = (viewport_height - (rows + 1) * gap) / rows;
+    int i = 0;
+    for (int row = 0; row < rows; row++)
+    {
+        int columns = legacy_tile_columns[count][row];
+        int col_width = (viewport_width - (columns + 1) * gap) / columns;
+        for (int column = 0; column < columns; column++, i++)
         {
-            // 3x2 grid. Two rows, three columns.
-            int col_width = (usable_width - 4 * gap) / 3;
-            int row_height = (usable_height - 3 * gap) / 2;
-            int row = index / 3;
-            int col = index % 3;
-            geometry.x_root = gap + col * (col_width + gap);
-            geometry.y_root = gap + row * (row_height + gap);
-            geometry.width = col_width;
-            geometry.height = row_height;
-            break;
+            out_geometries[i] = (PortalGeometry){
+                gap + column * (col_width + gap),
+                gap + row * (row_height + gap),
+                col_width, row_height
+            };
         }
-        case 7:
+    }
+}
+
+int check_tiling_layouts()
+{
+    // The viewports to check, along with the tile counts whose layout
+    // intentionally differs from the fixed layout table.
+    const struct {
+        const char *name;
+        int width, height;
+        unsigned int differing_counts;
+    } viewports[] = {
+        {"16:9", 1920, 1080, 0},
+        {"16:10", 1920, 1200, 0},
+        {"5:4", 1280, 1024, (1 << 3) | (1 << 8)}
+    };
+    const int gap = 8;
+
+    int failure_count = 0;
+    for (size_t v = 0; v < sizeof(viewports) / sizeof(viewports[0]); v++)
+    {
+        for (int count = 1; count <= 8; count++)
         {
-            // Top row: 3 columns. Bottom row: 4 columns.
-            int row_height = (usable_height - 3 * gap) / 2;
-            if (index < 3)
-            {
-                int col_width = (usable_width - 4 * gap) / 3;
-                geometry.x_root = gap + index * (col_width + gap);
-                geometry.y_root = gap;
-                geometry.width = col_width;
-                geometry.height = row_height;
-            }
-            else
+            PortalGeometry computed[8], legacy[8];
+            calc_tile_geometries(count, viewports[v].width, viewports[v].height, gap, computed);
+            calc_legacy_tile_geometries(count, viewports[v].width, viewports[v].height, gap, legacy);
+
+            // Compare the layouts tile by tile.
+            bool matches = true;
+            for (int i = 0; i < count; i++)
             {
-                int col_width = (usable_width - 5 * gap) / 4;
-                int col = index - 3;
-                geometry.x_root = gap + col * (col_width + gap);
-                geometry.y_root = gap + row_height + gap;
-                geometry.width = col_width;
-                geometry.height = row_height;
+                if (computed[i].x_root != legacy[i].x_root ||
+                    computed[i].y_root != legacy[i].y_root ||
+                    computed[i].width != legacy[i].width ||
+                    computed[i].height != legacy[i].height)
+                {
+                    matches = false;
+                }
             }
-            break;
-        }
-        case 8:
-        {
-            // 4x2 grid. Two rows, four columns.
-            int col_width = (usable_width - 5 * gap) / 4;
-            int row_height = (usable_height - 3 * gap) / 2;
-            int row = index / 4;
-            int col = index % 4;
-            geometry.x_root = gap + col * (col_width + gap);
-            geometry.y_root = gap + row * (row_height + gap);
-            geometry.width = col_width;
-            geometry.height = row_height;
-            break;
+
+            // Report the layouts that don't match the expectation.
+            bool expected = !(viewports[v].differing_counts & (1u << count));
+            if (matches == expected) continue;
+            fprintf(stderr,
+                "Tiling layout of %d portals at %s (%dx%d) %s the fixed layout table.\n",
+                count, viewports[v].name, viewports[v].width, viewports[v].height,
+                matches ? "unexpectedly matches" : "differs from"
+            );
+            failure_count++;
         }
-        default:
-            break;
     }
 
-    return geometry;
+    return (failure_count > 0) ? -1 : 0;
 }
 
 void apply_tiling_layout(int workspace)
@@ -244,22 +339,30 @@ void apply_tiling_layout(int workspace)
     int screen_width = DisplayWidth(display, screen);
     int screen_height = DisplayHeight(display, screen);
 
-    // Compute and apply tile geometries.
+    // Compute all tile geometries at once.
     int count = tile_order_count[workspace];
+    if (ensure_tile_capacity(&tile_geometries, &tile_geometries_capacity, count, sizeof(PortalGeometry)) != 0)
+    {
+        LOG_ERROR("Could not apply tiling layout, memory allocation failed.");
+        applying_layout = false;
+        return;
+    }
+    calc_tile_geometries(count, screen_width, screen_height, tile_gap, tile_geometries);
+
+    // Apply the tile geometries in a single transaction.
+    begin_portal_transaction();
     for (int i = 0; i < count; i++)
     {
         Portal *portal = tile_order[workspace][i];
         if (portal == NULL) continue;
         if (portal->fullscreen) continue;
 
-        PortalGeometry geometry = calc_tile_geometry(
-            count, i, screen_width, screen_height, tile_gap
-        );
-
         // Apply geometry through move_portal()/resize_portal().
+        PortalGeometry geometry = tile_geometries[i];
         move_portal(portal, geometry.x_root, geometry.y_root);
         resize_portal(portal, geometry.width, geometry.height);
     }
+    commit_portal_transaction();
 
     applying_layout = false;
 }
@@ -276,29 +379,45 @@ void cascade_tiled_portals(int workspace)
     int screen_width = DisplayWidth(display, screen);
     int screen_height = DisplayHeight(display, screen);
 
-    // Collect eligible portals in stacking order (bottom to top).
-    Portal *eligible[MAX_WORKSPACE_PORTALS];
-    int eligible_count = 0;
+    // Allocate memory for the eligible portals and their dimensions.
     unsigned int sorted_count = 0;
     Portal **sorted = get_sorted_portals(&sorted_count);
+    if (sorted_count == 0) return;
+    Portal **eligible = malloc(sorted_count * sizeof(Portal *));
+    unsigned int *widths = malloc(sorted_count * sizeof(unsigned int));
+    unsigned int *heights = malloc(sorted_count * sizeof(unsigned int));
+    if (eligible == NULL || widths == NULL || heights == NULL)
+    {
+        LOG_ERROR("Could not cascade tiled portals, memory allocation failed.");
+        free(eligible);
+        free(widths);
+        free(heights);
+        return;
+    }
+
+    // Collect eligible portals in stacking order (bottom to top).
+    int eligible_count = 0;
     for (unsigned int i = 0; i < sorted_count; i++)
     {
         Portal *portal = sorted[i];
         if (portal == NULL) continue;
         if (portal->workspace != workspace) continue;
         if (!is_tiling_eligible(portal)) continue;
-        if (eligible_count >= MAX_WORKSPACE_PORTALS) break;
         eligible[eligible_count++] = portal;
     }
-    if (eligible_count == 0) return;
+    if (eligible_count == 0)
+    {
+        free(eligible);
+        free(widths);
+        free(heights);
+        return;
+    }
 
     // Compute median of last floating widths and heights.
-    unsigned int widths[MAX_WORKSPACE_PORTALS];
-    unsigned int heights[MAX_WORKSPACE_PORTALS];
     for (int i = 0; i < eligible_count; i++)
     {
-        widths[i] = eligible[i]->geometry_floating_backup.width;
-        heights[i] = eligible[i]->geometry_floating_backup.height;
+        widths[i] = eligible[i]->cold->geometry_floating_backup.width;
+        heights[i] = eligible[i]->cold->geometry_floating_backup.height;
         if (widths[i] == 0) widths[i] = eligible[i]->geometry.width;
         if (heights[i] == 0) heights[i] = eligible[i]->geometry.height;
     }
@@ -342,7 +461,9 @@ void cascade_tiled_portals(int workspace)
     int start_x = (screen_width - group_width) / 2;
     int start_y = (screen_height - group_height) / 2;
 
-    // Position portals with diagonal offset in stacking order.
+    // Position portals with diagonal offset in stacking order, in a single
+    // transaction.
+    begin_portal_transaction();
     for (int i = 0; i < eligible_count; i++)
     {
         Portal *portal = eligible[i];
@@ -351,6 +472,11 @@ void cascade_tiled_portals(int workspace)
         resize_portal(portal, median_width, median_height);
         move_portal(portal, x, y);
     }
+    commit_portal_transaction();
+
+    free(eligible);
+    free(widths);
+    free(heights);
 }
 
 HANDLE(Initialize)
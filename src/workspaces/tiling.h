@@ -14,6 +14,17 @@ bool is_tiling_eligible(Portal *portal);
  */
 void append_to_tile_order(Portal *portal, int workspace);
 
+/**
+ * Inserts a portal into a workspace's tile order at the given position.
+ *
+ * @param portal The portal to insert.
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ * @param position The position to insert at, clamped to the tile order count.
+ *
+ * @note Does nothing if the portal is already in the tile order.
+ */
+void insert_into_tile_order(Portal *portal, int workspace, int position);
+
 /**
  * Removes a portal from a workspace's tile order.
  *
@@ -25,6 +36,16 @@ void remove_from_tile_order(Portal *portal, int workspace);
 /** Returns the number of portals in the tile order for a workspace. */
 int get_tile_order_count(int workspace);
 
+/**
+ * Retrieves the tile order of a workspace.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ * @param out_count Pointer to store the number of portals in the tile order.
+ *
+ * @return The portals in tile order, or `NULL` if the workspace is invalid.
+ */
+Portal **get_tile_order(int workspace, int *out_count);
+
 /** Clears the tile order for a workspace. */
 void clear_tile_order(int workspace);
 
@@ -38,6 +59,17 @@ void clear_tile_order(int workspace);
  */
 void apply_tiling_layout(int workspace);
 
+/**
+ * Checks the computed tile layouts of 1 to 8 portals against the fixed layout
+ * table they replaced, on 16:9, 16:10 and 5:4 viewports, printing each
+ * unexpected difference to `stderr`.
+ *
+ * @return - `0` All layouts match, except for those known to differ on 5:4 (3
+ * and 8 portals).
+ * @return - `-1` One or more layouts don't match the expectation.
+ */
+int check_tiling_layouts();
+
 /** Returns whether a tiling layout is currently being applied. */
 bool is_applying_tiling_layout();
 
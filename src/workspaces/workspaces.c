@@ -13,9 +13,29 @@ static int current_workspace = 0;
 /** Tracks the last focused portal on each workspace for focus restoration. */
 static Portal *last_focused_portal[MAX_WORKSPACES] = {NULL};
 
+/** The maximum number of non-transient portals per workspace, 0 until read. */
+static int workspace_capacity = 0;
+
 /** The layout mode of each workspace. */
 static WorkspaceLayoutMode workspace_layout_mode[MAX_WORKSPACES] = {WORKSPACE_LAYOUT_FLOATING};
 
+/** Whether each workspace awaits its tiling layout until the batch ends. */
+static bool tiling_layout_pending[MAX_WORKSPACES] = {false};
+
+/**
+ * Applies the tiling layout of a workspace. Within a portal batch, the layout
+ * is deferred until the batch ends, so it is applied only once.
+ */
+static void request_tiling_layout(int workspace)
+{
+    if (is_portal_batch_in_progress())
+    {
+        tiling_layout_pending[workspace] = true;
+        return;
+    }
+    apply_tiling_layout(workspace);
+}
+
 /**
  * Moves a single portal to the given workspace without any group or limit
  * logic. Caller is responsible for validation and workspace-limit checks.
@@ -57,6 +77,24 @@ int get_current_workspace()
     return current_workspace;
 }
 
+int get_workspace_capacity()
+{
+    // Read the workspace capacity from config on first use, as adoption
+    // already needs it while initializing.
+    if (workspace_capacity == 0)
+    {
+        char capacity_value[CONFIG_MAX_VALUE_LENGTH];
+        common.get_config_str(
+            capacity_value, sizeof(capacity_value),
+            CFG_KEY_WORKSPACE_CAPACITY, CFG_DEFAULT_WORKSPACE_CAPACITY
+        );
+        workspace_capacity = atoi(capacity_value);
+        if (workspace_capacity < 1) workspace_capacity = 1;
+        if (workspace_capacity > MAX_WORKSPACE_CAPACITY) workspace_capacity = MAX_WORKSPACE_CAPACITY;
+    }
+    return workspace_capacity;
+}
+
 int determine_portal_workspace(Portal *portal)
 {
     return (portal->workspace != -1) ? portal->workspace : current_workspace;
@@ -65,11 +103,11 @@ int determine_portal_workspace(Portal *portal)
 int count_workspace_portals(int workspace)
 {
     int count = 0;
-    Portal *portals = get_unsorted_portals();
-    for (unsigned int i = 0; i < MAX_PORTALS; i++)
+    unsigned int portal_count = 0;
+    Portal **portals = get_active_portals(&portal_count);
+    for (unsigned int i = 0; i < portal_count; i++)
     {
-        Portal *portal = &portals[i];
-        if (!portal->active) continue;
+        Portal *portal = portals[i];
         if (!portal->initialized) continue;
         if (portal->workspace != workspace) continue;
         if (portal->visibility == PORTAL_HIDDEN) continue;
@@ -95,11 +133,11 @@ void move_portal_to_workspace(Portal *portal, int workspace)
     // Deny move to a full workspace (only non-transient root counts toward
     // the limit, skip the check if the root is already on that workspace).
     if (root->transient_for == NULL &&
-        count_workspace_portals(workspace) >= MAX_WORKSPACE_PORTALS)
+        count_workspace_portals(workspace) >= get_workspace_capacity())
     {
         LOG_WARNING(
             "Workspace %d is full (%d portals); move denied.",
-            workspace, MAX_WORKSPACE_PORTALS
+            workspace, get_workspace_capacity()
         );
         return;
     }
@@ -108,11 +146,11 @@ void move_portal_to_workspace(Portal *portal, int workspace)
     move_single_portal_to_workspace(root, workspace);
 
     // Move all transient children belonging to the same group.
-    Portal *portals = get_unsorted_portals();
-    for (unsigned int i = 0; i < MAX_PORTALS; i++)
+    unsigned int portal_count = 0;
+    Portal **portals = get_active_portals(&portal_count);
+    for (unsigned int i = 0; i < portal_count; i++)
     {
-        Portal *candidate = &portals[i];
-        if (!candidate->active) continue;
+        Portal *candidate = portals[i];
         if (!candidate->initialized) continue;
         if (candidate->transient_for == NULL) continue;
         if (find_portal_transient_root(candidate) == root)
@@ -136,32 +174,30 @@ void switch_workspace(int workspace)
     // Ensure we're switching to a different workspace.
     if (workspace == current_workspace) return;
 
-    // Save the currently focused window for the current workspace.
-    Window focused_window = None;
-    int revert_to = 0;
-    XGetInputFocus(display, &focused_window, &revert_to);
-    if (focused_window != None && focused_window != PointerRoot)
+    TimelineSpan span = begin_timeline_span("workspaces", "switch_workspace");
+
+    // Save the currently focused portal for the current workspace.
+    Portal *focused_portal = get_focused_portal();
+    if (focused_portal != NULL && focused_portal->workspace == current_workspace)
     {
-        Portal *focused_portal = find_portal_by_window(focused_window);
-        if (focused_portal != NULL && focused_portal->workspace == current_workspace)
-        {
-            last_focused_portal[current_workspace] = focused_portal;
-        }
+        last_focused_portal[current_workspace] = focused_portal;
     }
 
     // Update current workspace.
     int old_workspace = current_workspace;
     current_workspace = workspace;
 
-    // Update portal visibility based on workspace assignment.
-    Portal *portals = get_unsorted_portals();
-    for (unsigned int i = 0; i < MAX_PORTALS; i++)
+    // Update portal visibility based on workspace assignment in a single
+    // batch, so stacking and the client list are resolved only once.
+    begin_portal_batch();
+    unsigned int portal_count = 0;
+    Portal **portals = get_active_portals(&portal_count);
+    for (unsigned int i = 0; i < portal_count; i++)
     {
-        Portal *portal = &portals[i];
+        Portal *portal = portals[i];
 
-        // Skip inactive slots, uninitialized portals, override-redirect windows
-        // (they manage themselves), and unassigned portals (workspace < 0).
-        if (!portal->active) continue;
+        // Skip uninitialized portals, override-redirect windows (they
+        // manage themselves), and unassigned portals (workspace < 0).
         if (!portal->initialized) continue;
         if (portal->override_redirect) continue;
         if (portal->workspace < 0) continue;
@@ -188,7 +224,9 @@ void switch_workspace(int workspace)
         }
     }
 
-    // Fallback to topmost visible portal if no last focused portal is available.
+    // Fallback to topmost visible portal if no last focused portal is
+    // available. Revealing portals doesn't restack them, so the sorted
+    // portals are still current within the batch.
     if (to_focus == NULL)
     {
         unsigned int sorted_count = 0;
@@ -204,12 +242,19 @@ void switch_workspace(int workspace)
         }
     }
 
+    // Raise the portal to focus within the batch, so it is stacked as part
+    // of the single stacking resolution.
+    if (to_focus != NULL)
+    {
+        raise_portal(to_focus);
+    }
+    end_portal_batch();
+
     // Focus the determined portal or clear focus.
     if (to_focus != NULL)
     {
         // Focus the portal.
         x_focus_window(display, to_focus->client_window);
-        raise_portal(to_focus);
         call_event_handlers((Event*)&(PortalFocusedEvent){
             .type = PortalFocused,
             .portal = to_focus
@@ -219,6 +264,10 @@ void switch_workspace(int workspace)
     {
         // No portals on this workspace, clear focus to root.
         x_focus_window(display, DefaultRootWindow(display));
+        call_event_handlers((Event*)&(PortalFocusedEvent){
+            .type = PortalFocused,
+            .portal = NULL
+        });
     }
 
     // Notify listeners of the workspace switch.
@@ -227,6 +276,8 @@ void switch_workspace(int workspace)
         .old_workspace = old_workspace,
         .new_workspace = workspace
     });
+
+    end_timeline_span(&span);
 }
 
 WorkspaceLayoutMode get_workspace_layout_mode(int workspace)
@@ -238,6 +289,24 @@ WorkspaceLayoutMode get_workspace_layout_mode(int workspace)
     return workspace_layout_mode[workspace];
 }
 
+void set_workspace_layout_mode(int workspace, WorkspaceLayoutMode mode)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
+    workspace_layout_mode[workspace] = mode;
+}
+
+Portal *get_last_focused_portal(int workspace)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return NULL;
+    return last_focused_portal[workspace];
+}
+
+void set_last_focused_portal(int workspace, Portal *portal)
+{
+    if (workspace < 0 || workspace >= MAX_WORKSPACES) return;
+    last_focused_portal[workspace] = portal;
+}
+
 bool is_portal_tiled(Portal *portal)
 {
     if (portal->transient_for != NULL) return false;
@@ -328,7 +397,7 @@ HANDLE(PortalDestroyed)
         else if (workspace_layout_mode[workspace] == WORKSPACE_LAYOUT_TILING)
         {
             // Recompute layout for the remaining portals.
-            apply_tiling_layout(workspace);
+            request_tiling_layout(workspace);
         }
     }
 }
@@ -347,7 +416,7 @@ HANDLE(PortalTransformed)
     if (portal->transient_for != NULL) return;
     if (portal->override_redirect) return;
 
-    portal->geometry_floating_backup = portal->geometry;
+    portal->cold->geometry_floating_backup = portal->geometry;
 }
 
 HANDLE(PortalMapped)
@@ -364,11 +433,8 @@ HANDLE(PortalMapped)
     if (_event->first_map &&
         workspace_layout_mode[workspace] == WORKSPACE_LAYOUT_FLOATING)
     {
-        Display *display = DefaultDisplay;
-        char new_class[256] = {0};
-        if (x_get_window_class(display, portal->client_window,
-            new_class, sizeof(new_class)) == 0 &&
-            new_class[0] != '\0')
+        const char *new_class = portal->cold->properties.wm_class;
+        if (new_class[0] != '\0')
         {
             // Find topmost sibling with same WM_CLASS.
             unsigned int sorted_count = 0;
@@ -382,12 +448,7 @@ HANDLE(PortalMapped)
                 if (!sibling->active) continue;
                 if (!sibling->initialized) continue;
                 if (sibling->visibility != PORTAL_VISIBLE) continue;
-                char sibling_class[256] = {0};
-                if (x_get_window_class(display,
-                    sibling->client_window,
-                    sibling_class,
-                    sizeof(sibling_class)) == 0 &&
-                    strcmp(new_class, sibling_class) == 0)
+                if (strcmp(new_class, sibling->cold->properties.wm_class) == 0)
                 {
                     // Offset diagonally from sibling.
                     move_portal(portal,
@@ -400,8 +461,9 @@ HANDLE(PortalMapped)
     }
 
     // Check for auto-tiling: if in Floating mode and portal exceeds the
-    // viewport threshold, switch to Tiling.
-    if (workspace_layout_mode[workspace] == WORKSPACE_LAYOUT_FLOATING)
+    // viewport threshold, switch to Tiling. A restored layout mode is kept.
+    if (workspace_layout_mode[workspace] == WORKSPACE_LAYOUT_FLOATING &&
+        !is_restoring_session_state())
     {
         Display *display = DefaultDisplay;
         int screen = DefaultScreen(display);
@@ -423,6 +485,18 @@ HANDLE(PortalMapped)
     if (workspace_layout_mode[workspace] == WORKSPACE_LAYOUT_TILING)
     {
         append_to_tile_order(portal, workspace);
+        request_tiling_layout(workspace);
+    }
+}
+
+HANDLE(PortalBatchEnded)
+{
+    // Apply the tiling layouts deferred during the batch.
+    for (int workspace = 0; workspace < MAX_WORKSPACES; workspace++)
+    {
+        if (!tiling_layout_pending[workspace]) continue;
+        tiling_layout_pending[workspace] = false;
+        if (workspace_layout_mode[workspace] != WORKSPACE_LAYOUT_TILING) continue;
         apply_tiling_layout(workspace);
     }
 }
@@ -450,7 +524,7 @@ HANDLE(PortalWorkspaceChanged)
         }
         else if (workspace_layout_mode[old_workspace] == WORKSPACE_LAYOUT_TILING)
         {
-            apply_tiling_layout(old_workspace);
+            request_tiling_layout(old_workspace);
         }
     }
 
@@ -467,7 +541,7 @@ HANDLE(PortalWorkspaceChanged)
         if (workspace_layout_mode[new_workspace] == WORKSPACE_LAYOUT_TILING)
         {
             append_to_tile_order(portal, new_workspace);
-            apply_tiling_layout(new_workspace);
+            request_tiling_layout(new_workspace);
         }
     }
 }
@@ -482,4 +556,3 @@ HANDLE(ShortcutPressed)
     // Toggle the layout mode of the current workspace.
     toggle_workspace_layout_mode();
 }
-
@@ -4,8 +4,8 @@
 /** The maximum number of workspaces supported by the window manager. */
 #define MAX_WORKSPACES 6
 
-/** The maximum number of non-transient portals per workspace. */
-#define MAX_WORKSPACE_PORTALS 8
+/** The maximum configurable number of non-transient portals per workspace. */
+#define MAX_WORKSPACE_CAPACITY 32
 
 /** The viewport percentage used for auto-tiling thresholds. */
 #define WORKSPACE_VIEWPORT_THRESHOLD_PERCENT 75
@@ -23,6 +23,12 @@ typedef enum
 /** Returns the current workspace index. */
 int get_current_workspace();
 
+/**
+ * Returns the maximum number of non-transient portals per workspace, as
+ * configured, between 1 and `MAX_WORKSPACE_CAPACITY`.
+ */
+int get_workspace_capacity();
+
 /**
  * Checks whether a portal is currently tiled.
  *
@@ -42,6 +48,32 @@ bool is_portal_tiled(Portal *portal);
  */
 WorkspaceLayoutMode get_workspace_layout_mode(int workspace);
 
+/**
+ * Sets the layout mode of a workspace, without rearranging its portals.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ * @param mode The layout mode.
+ */
+void set_workspace_layout_mode(int workspace, WorkspaceLayoutMode mode);
+
+/**
+ * Queries the last focused portal of a workspace, which receives focus when
+ * the workspace is switched to.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ *
+ * @return The last focused portal, or `NULL` if there is none.
+ */
+Portal *get_last_focused_portal(int workspace);
+
+/**
+ * Sets the last focused portal of a workspace.
+ *
+ * @param workspace The workspace index (0 to MAX_WORKSPACES - 1).
+ * @param portal The portal, or `NULL` to clear it.
+ */
+void set_last_focused_portal(int workspace, Portal *portal);
+
 /** Toggles the layout mode of the current workspace. */
 void toggle_workspace_layout_mode();
 